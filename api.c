@@ -0,0 +1,210 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "pspretty.h"
+
+/*
+ * Implementation of public API (libpspretty.h). The API call is
+ * protected by setjmp, so fatal errors of parser (out of memory)
+ * are returned as error code instead of exit of process.
+ */
+struct PsContext
+{
+	PsParser	ps;
+	PsFormatOptions format;
+	PsOutput	out;				/* buffer for formatted statement */
+	Node	   *node;				/* last parsed statement */
+};
+
+static void
+api_error(PsContext *ctx, PsErrorCode code, const char *msg)
+{
+	reset_parser_error(&ctx->ps);
+	parser_error(&ctx->ps, code, "%s", msg);
+}
+
+PsContext *
+pspretty_create(void)
+{
+	PsContext  *volatile ctx;	/* it is used after longjmp */
+	jmp_buf		error_jmp;
+
+	ctx = malloc(sizeof(PsContext));
+	if (!ctx)
+		return NULL;
+
+	init_psparser(&ctx->ps);
+	ctx->ps.quiet = true;
+	ctx->ps.token_array = true;
+
+	init_format_options(&ctx->format);
+	ctx->node = NULL;
+
+	/* the allocation of output buffer can fail */
+	memset(&ctx->out, 0, sizeof(PsOutput));
+	if (setjmp(error_jmp) != 0)
+	{
+		set_error_context(NULL);
+		free(ctx);
+		return NULL;
+	}
+
+	ctx->ps.error_jmp = &error_jmp;
+	set_error_context(&ctx->ps);
+
+	init_output_buffer(&ctx->out);
+
+	ctx->ps.error_jmp = NULL;
+	set_error_context(NULL);
+
+	return ctx;
+}
+
+void
+pspretty_free(PsContext *ctx)
+{
+	if (!ctx)
+		return;
+
+	free_psparser(&ctx->ps);
+	free_output(&ctx->out);
+	free(ctx);
+}
+
+void
+pspretty_set_lower_keywords(PsContext *ctx, bool lower)
+{
+	ctx->format.keyword_case = lower ? kc_lower : kc_upper;
+}
+
+void
+pspretty_set_indent_width(PsContext *ctx, int width)
+{
+	ctx->format.indent_width = width > 0 ? width : 0;
+}
+
+void
+pspretty_set_line_width(PsContext *ctx, int width)
+{
+	ctx->format.line_width = width > 0 ? width : 0;
+}
+
+void
+pspretty_set_max_depth(PsContext *ctx, int depth)
+{
+	ctx->ps.max_depth = depth > 0 ? depth : 1;
+}
+
+void
+pspretty_set_max_nodes(PsContext *ctx, long long nodes)
+{
+	ctx->ps.budget.max_nodes = nodes > 0 ? nodes : 0;
+}
+
+void
+pspretty_set_max_tokens(PsContext *ctx, long long tokens)
+{
+	ctx->ps.budget.max_tokens = tokens > 0 ? tokens : 0;
+}
+
+void
+pspretty_set_timeout(PsContext *ctx, int msec)
+{
+	ctx->ps.budget.timeout = msec > 0 ? msec : 0;
+}
+
+void
+pspretty_set_mmap_nodes(PsContext *ctx, bool mmap_nodes, bool huge_pages)
+{
+	ctx->ps.mmap_nodes = mmap_nodes;
+	ctx->ps.huge_pages = mmap_nodes && huge_pages;
+}
+
+PsErrorCode
+pspretty_parse(PsContext *ctx, const char *str, size_t len)
+{
+	PsParser   *ps = &ctx->ps;
+	jmp_buf		error_jmp;
+
+	ctx->node = NULL;
+
+	reset_parser_error(ps);
+
+	if (setjmp(error_jmp) != 0)
+	{
+		ps->error_jmp = NULL;
+		set_error_context(NULL);
+
+		return ps->error_code;
+	}
+
+	ps->error_jmp = &error_jmp;
+	set_error_context(ps);
+
+	/* the parser doesn't modify input */
+	ctx->node = parser(ps, (char *) str, len, false);
+
+	ps->error_jmp = NULL;
+	set_error_context(NULL);
+
+	if (!ctx->node && ps->error_code == PS_OK)
+		api_error(ctx, PS_ERROR_SYNTAX, "syntax error");
+
+	return ps->error_code;
+}
+
+PsErrorCode
+pspretty_format(PsContext *ctx, char *buffer, size_t size, size_t *len)
+{
+	PsParser   *ps = &ctx->ps;
+	jmp_buf		error_jmp;
+
+	if (!ctx->node)
+	{
+		api_error(ctx, PS_ERROR_NO_STATEMENT, "there is no parsed statement");
+		return ps->error_code;
+	}
+
+	reset_parser_error(ps);
+
+	if (setjmp(error_jmp) != 0)
+	{
+		ps->error_jmp = NULL;
+		set_error_context(NULL);
+
+		return ps->error_code;
+	}
+
+	ps->error_jmp = &error_jmp;
+	set_error_context(ps);
+
+	ctx->out.used = 0;
+	format_statement(&ctx->out, ctx->node, &ctx->format);
+
+	ps->error_jmp = NULL;
+	set_error_context(NULL);
+
+	*len = ctx->out.used;
+
+	if (ctx->out.used > size)
+	{
+		api_error(ctx, PS_ERROR_BUFFER_TOO_SMALL, "buffer is too small");
+		return ps->error_code;
+	}
+
+	memcpy(buffer, ctx->out.data, ctx->out.used);
+
+	return PS_OK;
+}
+
+PsErrorCode
+pspretty_errcode(PsContext *ctx)
+{
+	return ctx->ps.error_code;
+}
+
+const char *
+pspretty_errmsg(PsContext *ctx)
+{
+	return ctx->ps.errmsg;
+}
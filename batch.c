@@ -0,0 +1,335 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pspretty.h"
+
+/*
+ * Parallel processing of statements. The statements (usually from
+ * feeder in text mode) are collected to jobs, and the jobs are
+ * processed by pool of worker threads. Every worker has own parser
+ * context (and then own lexer and node allocator). The output and
+ * the error messages of every job are written to its own buffers, and
+ * the buffers are written to final output and stderr in original
+ * order by the thread that adds jobs.
+ *
+ * The jobs are in ring buffer of fixed size, so the memory is limited
+ * when the workers are slower than reading of input.
+ */
+
+/* jobs are not smaller than this, so locks are not too often */
+#define BATCH_JOB_SIZE		(64 * 1024)
+
+/* number of jobs per worker */
+#define BATCH_JOBS_PER_WORKER		4
+
+/*
+ * Writes finished jobs in original order. Waits on unfinished jobs,
+ * while there are more than max_unwritten not written jobs.
+ */
+static void
+write_jobs(PsBatch *b, uint64_t max_unwritten)
+{
+	pthread_mutex_lock(&b->mutex);
+
+	while (b->next_write < b->next_seq)
+	{
+		BatchJob   *job = &b->jobs[b->next_write % b->njobs];
+
+		if (!job->done)
+		{
+			if (b->next_seq - b->next_write <= max_unwritten)
+				break;
+
+			pthread_cond_wait(&b->job_done, &b->mutex);
+			continue;
+		}
+
+		pthread_mutex_unlock(&b->mutex);
+
+		output_write(b->out, job->out.data, job->out.used);
+		job->out.used = 0;
+
+		if (job->err.used > 0)
+		{
+			fwrite(job->err.data, 1, job->err.used, stderr);
+			job->err.used = 0;
+		}
+
+		pthread_mutex_lock(&b->mutex);
+
+		job->done = false;
+		b->next_write += 1;
+	}
+
+	pthread_mutex_unlock(&b->mutex);
+}
+
+/*
+ * Returns job, that will be submitted next. When it is not free yet,
+ * then waits until it is finished and written.
+ */
+static BatchJob *
+pending_job(PsBatch *b)
+{
+	write_jobs(b, b->njobs - 1);
+
+	return &b->jobs[b->next_seq % b->njobs];
+}
+
+/*
+ * Passes pending job to workers
+ */
+static void
+submit_job(PsBatch *b)
+{
+	if (!b->pending)
+		return;
+
+	pthread_mutex_lock(&b->mutex);
+
+	b->next_seq += 1;
+	b->pending = false;
+
+	pthread_cond_signal(&b->job_ready);
+	pthread_mutex_unlock(&b->mutex);
+
+	/* don't hold finished jobs longer than necessary */
+	write_jobs(b, b->njobs);
+}
+
+static void *
+batch_worker(void *arg)
+{
+	PsBatch	   *b = arg;
+	PsParser	ps;
+	PsStats		stats;
+
+	init_psparser(&ps);
+	init_stats(&stats);
+
+	/* errors are written to stderr with output of job, in order */
+	ps.quiet = true;
+
+	pthread_mutex_lock(&b->mutex);
+
+	for (;;)
+	{
+		BatchJob   *job;
+		Node	   *node;
+		bool		error;
+
+		while (b->next_dispatch == b->next_seq && !b->shutdown)
+			pthread_cond_wait(&b->job_ready, &b->mutex);
+
+		if (b->next_dispatch == b->next_seq)
+			break;
+
+		job = &b->jobs[b->next_dispatch++ % b->njobs];
+		ps.stats = b->stats ? &stats : NULL;
+		ps.max_depth = b->max_depth;
+		ps.mmap_nodes = b->mmap_nodes;
+		ps.huge_pages = b->huge_pages;
+		ps.budget = b->budget;
+		ps.errout = &job->err;
+
+		pthread_mutex_unlock(&b->mutex);
+
+		init_lexer(&ps, job->str, job->len, b->force8bit);
+		ps.line_offset = job->lineno;
+		ps.pos_offset = job->pos;
+
+		while ((node = parse_next_statement(&ps, &error)) || error)
+			b->callback(&ps, node, &job->out, b->callback_arg);
+
+		pthread_mutex_lock(&b->mutex);
+
+		job->done = true;
+		pthread_cond_broadcast(&b->job_done);
+	}
+
+	pthread_mutex_unlock(&b->mutex);
+
+	free_psparser(&ps);
+
+	if (b->stats)
+	{
+		pthread_mutex_lock(&b->mutex);
+		merge_stats(b->stats, &stats);
+		pthread_mutex_unlock(&b->mutex);
+	}
+
+	return NULL;
+}
+
+/*
+ * Initialize batch and starts worker threads. The callback is called
+ * by worker for every statement, and it should to write result to
+ * passed output. The results are written to out.
+ *
+ * When some threads cannot be created, then the batch uses less
+ * workers. Returns false (and batch cannot be used), when no worker
+ * was started.
+ */
+bool
+init_batch(PsBatch *b, int nworkers, PsOutput *out, bool force8bit,
+		   PsBatchCallback callback, void *callback_arg)
+{
+	int		i;
+
+	memset(b, 0, sizeof(PsBatch));
+
+	b->out = out;
+	b->force8bit = force8bit;
+	b->callback = callback;
+	b->callback_arg = callback_arg;
+	b->max_depth = PS_DEFAULT_MAX_DEPTH;
+
+	b->njobs = nworkers * BATCH_JOBS_PER_WORKER;
+	b->jobs = malloc(b->njobs * sizeof(BatchJob));
+	if (!b->jobs)
+		out_of_memory();
+
+	memset(b->jobs, 0, b->njobs * sizeof(BatchJob));
+
+	for (i = 0; i < b->njobs; i++)
+	{
+		init_output_buffer(&b->jobs[i].out);
+		init_output_buffer(&b->jobs[i].err);
+	}
+
+	pthread_mutex_init(&b->mutex, NULL);
+	pthread_cond_init(&b->job_ready, NULL);
+	pthread_cond_init(&b->job_done, NULL);
+
+	b->workers = malloc(nworkers * sizeof(pthread_t));
+	if (!b->workers)
+		out_of_memory();
+
+	b->nworkers = 0;
+
+	for (i = 0; i < nworkers; i++)
+	{
+		if (pthread_create(&b->workers[i], NULL, batch_worker, b) != 0)
+			break;
+
+		b->nworkers += 1;
+	}
+
+	if (b->nworkers == 0)
+	{
+		free_batch(b);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Adds text of statement (or more statements). The consecutive
+ * statements are merged to one job. When the text is not stable,
+ * then it is copied.
+ */
+void
+batch_add(PsBatch *b, const char *str, size_t len,
+		  int lineno, int pos, bool stable)
+{
+	BatchJob   *job;
+
+	if (b->pending)
+	{
+		job = &b->jobs[b->next_seq % b->njobs];
+
+		/* stable text can be merged only when it follows pending job */
+		if (job->stable != stable ||
+			(stable && job->str + job->len != str))
+			submit_job(b);
+	}
+
+	if (!b->pending)
+	{
+		job = pending_job(b);
+
+		job->lineno = lineno;
+		job->pos = pos;
+		job->stable = stable;
+		job->len = 0;
+
+		if (stable)
+			job->str = (char *) str;
+
+		b->pending = true;
+	}
+
+	if (stable)
+		job->len += len;
+	else
+	{
+		if (job->len + len > job->size)
+		{
+			size_t	size = job->size > 0 ? job->size : BATCH_JOB_SIZE;
+
+			while (size < job->len + len)
+				size *= 2;
+
+			job->buffer = realloc(job->buffer, size);
+			if (!job->buffer)
+				out_of_memory();
+
+			job->size = size;
+		}
+
+		memcpy(job->buffer + job->len, str, len);
+		job->str = job->buffer;
+		job->len += len;
+	}
+
+	if (job->len >= BATCH_JOB_SIZE)
+		submit_job(b);
+}
+
+/*
+ * Waits on all jobs, and writes their output. After this the
+ * stable texts passed to batch_add are not used.
+ */
+void
+finish_batch(PsBatch *b)
+{
+	submit_job(b);
+	write_jobs(b, 0);
+}
+
+/*
+ * Finish all jobs and stops workers
+ */
+void
+free_batch(PsBatch *b)
+{
+	int		i;
+
+	finish_batch(b);
+
+	pthread_mutex_lock(&b->mutex);
+	b->shutdown = true;
+	pthread_cond_broadcast(&b->job_ready);
+	pthread_mutex_unlock(&b->mutex);
+
+	for (i = 0; i < b->nworkers; i++)
+		pthread_join(b->workers[i], NULL);
+
+	for (i = 0; i < b->njobs; i++)
+	{
+		free_output(&b->jobs[i].out);
+		free_output(&b->jobs[i].err);
+		free(b->jobs[i].buffer);
+	}
+
+	pthread_mutex_destroy(&b->mutex);
+	pthread_cond_destroy(&b->job_ready);
+	pthread_cond_destroy(&b->job_done);
+
+	free(b->jobs);
+	free(b->workers);
+
+	memset(b, 0, sizeof(PsBatch));
+}
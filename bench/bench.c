@@ -0,0 +1,304 @@
+/*
+ * Benchmark of lexer, parser and formatter. Every stage is measured
+ * separately over all statements of input file, and the best time of
+ * more runs is used. The results are written as JSON to stdout, so
+ * they can be compared across commits.
+ *
+ * Usage: bench [-r runs] file ...
+ *
+ * The corpus can be generated by gen_corpus.
+ *
+ * lexer	all tokens are read by next_token (without token array)
+ * parser	statements are tokenized and parsed by parse_next_statement
+ * output	parsed statements are formatted to memory buffer
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "pspretty.h"
+
+typedef struct
+{
+	double		seconds;
+	long long	bytes;			/* processed bytes (input or output) */
+	long long	tokens;
+	long long	nodes;
+	long long	statements;
+	long long	errors;
+} StageResult;
+
+static double
+now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Returns number of nodes of last parsed statement
+ */
+static long long
+count_nodes(PsParser *ps)
+{
+	NodeAllocator *na;
+	long long	nodes = 0;
+
+	for (na = ps->root_allocator; na; na = na->next)
+	{
+		nodes += na->used;
+
+		if (na == ps->current_allocator)
+			break;
+	}
+
+	return nodes;
+}
+
+static void
+bench_lexer(PsParser *ps, char *str, size_t len, StageResult *result)
+{
+	Token		t, *_t;
+	double		start = now();
+
+	init_lexer(ps, str, len, false);
+
+	while ((_t = next_token(ps, &t)) && _t->type != tt_EOF)
+		result->tokens += 1;
+
+	if (!_t)
+		result->errors += 1;
+
+	result->seconds = now() - start;
+	result->bytes = len;
+}
+
+static void
+bench_parser(PsParser *ps, char *str, size_t len, StageResult *result)
+{
+	Node	   *node;
+	bool		error;
+	double		start = now();
+
+	init_lexer(ps, str, len, false);
+
+	while ((node = parse_next_statement(ps, &error)) || error)
+	{
+		/* tokens of statement are closed by EOF token */
+		result->tokens += ps->ntokens - 1;
+		result->statements += 1;
+
+		if (node)
+			result->nodes += count_nodes(ps);
+		else
+			result->errors += 1;
+	}
+
+	result->seconds = now() - start;
+	result->bytes = len;
+}
+
+/*
+ * Only formatting is measured, the statements are parsed before
+ */
+static void
+bench_output(PsParser *ps, char *str, size_t len, StageResult *result)
+{
+	PsFormatOptions opts;
+	PsOutput	out;
+	Node	   *node;
+	bool		error;
+
+	init_format_options(&opts);
+	init_output_buffer(&out);
+
+	init_lexer(ps, str, len, false);
+
+	while ((node = parse_next_statement(ps, &error)) || error)
+	{
+		double		start;
+
+		result->statements += 1;
+
+		if (!node)
+		{
+			result->errors += 1;
+			continue;
+		}
+
+		start = now();
+		format_statement(&out, node, &opts);
+		result->seconds += now() - start;
+
+		result->nodes += count_nodes(ps);
+		result->bytes += out.used;
+		out.used = 0;
+	}
+
+	free_output(&out);
+}
+
+static void
+print_stage(const char *name, StageResult *result, bool last)
+{
+	double		seconds = result->seconds > 0 ? result->seconds : 1e-9;
+
+	printf("    \"%s\": {\n", name);
+	printf("      \"seconds\": %.6f,\n", result->seconds);
+	printf("      \"bytes\": %lld,\n", result->bytes);
+	printf("      \"mb_per_s\": %.2f,\n", result->bytes / seconds / (1024 * 1024));
+	printf("      \"tokens\": %lld,\n", result->tokens);
+	printf("      \"tokens_per_s\": %.0f,\n", result->tokens / seconds);
+	printf("      \"nodes\": %lld,\n", result->nodes);
+	printf("      \"nodes_per_s\": %.0f,\n", result->nodes / seconds);
+	printf("      \"statements\": %lld,\n", result->statements);
+	printf("      \"errors\": %lld\n", result->errors);
+	printf("    }%s\n", last ? "" : ",");
+}
+
+static void
+print_json_string(const char *str)
+{
+	putchar('"');
+
+	for (; *str; str++)
+	{
+		if (*str == '"' || *str == '\\')
+			printf("\\%c", *str);
+		else if ((unsigned char) *str < 0x20)
+			printf("\\u%04x", *str);
+		else
+			putchar(*str);
+	}
+
+	putchar('"');
+}
+
+typedef void (*StageFunc) (PsParser *ps, char *str, size_t len, StageResult *result);
+
+/*
+ * Runs stage more times, and returns the fastest run
+ */
+static void
+run_stage(StageFunc func, PsParser *ps, char *str, size_t len,
+		  int runs, StageResult *best)
+{
+	int		i;
+
+	for (i = 0; i < runs; i++)
+	{
+		StageResult result;
+
+		memset(&result, 0, sizeof(StageResult));
+		func(ps, str, len, &result);
+
+		if (i == 0 || result.seconds < best->seconds)
+			*best = result;
+	}
+}
+
+static void
+bench_file(const char *name, int runs, bool last)
+{
+	StageResult lexer, parser, output;
+	PsParser	ps;
+	struct stat st;
+	char	   *str;
+	size_t		len;
+	int			fd;
+
+	fd = open(name, O_RDONLY);
+	if (fd < 0 || fstat(fd, &st) < 0)
+	{
+		fprintf(stderr, "cannot open \"%s\": %s\n", name, strerror(errno));
+		exit(1);
+	}
+
+	len = (size_t) st.st_size;
+	if (len == 0)
+	{
+		fprintf(stderr, "file \"%s\" is empty\n", name);
+		exit(1);
+	}
+
+	str = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (str == MAP_FAILED)
+	{
+		fprintf(stderr, "cannot map \"%s\": %s\n", name, strerror(errno));
+		exit(1);
+	}
+
+	close(fd);
+
+	init_psparser(&ps);
+	ps.token_array = true;
+
+	run_stage(bench_lexer, &ps, str, len, runs, &lexer);
+	run_stage(bench_parser, &ps, str, len, runs, &parser);
+	run_stage(bench_output, &ps, str, len, runs, &output);
+
+	free_psparser(&ps);
+	munmap(str, len);
+
+	printf("  {\n");
+	printf("    \"file\": ");
+	print_json_string(name);
+	printf(",\n");
+	printf("    \"bytes\": %zu,\n", len);
+	printf("    \"runs\": %d,\n", runs);
+	print_stage("lexer", &lexer, false);
+	print_stage("parser", &parser, false);
+	print_stage("output", &output, true);
+	printf("  }%s\n", last ? "" : ",");
+}
+
+static void
+usage(const char *progname)
+{
+	fprintf(stderr, "Usage: %s [-r runs] file ...\n", progname);
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	int		runs = 3;
+	int		c;
+	int		i;
+
+	while ((c = getopt(argc, argv, "r:")) != -1)
+	{
+		switch (c)
+		{
+			case 'r':
+				runs = atoi(optarg);
+				if (runs < 1)
+					usage(argv[0]);
+				break;
+
+			default:
+				usage(argv[0]);
+		}
+	}
+
+	if (optind >= argc)
+		usage(argv[0]);
+
+	printf("[\n");
+
+	for (i = optind; i < argc; i++)
+		bench_file(argv[i], runs, i == argc - 1);
+
+	printf("]\n");
+
+	return 0;
+}
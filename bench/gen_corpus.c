@@ -0,0 +1,311 @@
+/*
+ * Generates synthetic SQL corpus for benchmarks. The output is
+ * deterministic for given shape, size and seed, so the results of
+ * benchmark can be compared across commits.
+ *
+ * Usage: gen_corpus [-s seed] [-n count] [-S megabytes] shape > file.sql
+ *
+ * Shapes:
+ *
+ *   columns	one SELECT with n columns (default 5000)
+ *   predicate	one SELECT with n terms in AND/OR predicate (default 10000)
+ *   in			one SELECT with IN list of n values (default 100000)
+ *   join		one SELECT with chain of n joins (default 50)
+ *   nested		one SELECT with n nested subqueries (default 200)
+ *   mixed		short queries, size of output is -S megabytes (default 64)
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static uint64_t random_state;
+
+/*
+ * xorshift64, the output doesn't depend on libc
+ */
+static uint64_t
+next_random(void)
+{
+	random_state ^= random_state << 13;
+	random_state ^= random_state >> 7;
+	random_state ^= random_state << 17;
+
+	return random_state;
+}
+
+static int
+random_int(int n)
+{
+	return (int) (next_random() % (uint64_t) n);
+}
+
+static const char *column_names[] = {
+	"id", "name", "created_at", "amount", "status", "customer_id",
+	"price", "quantity", "description", "updated_at"
+};
+
+#define NCOLUMN_NAMES	((int) (sizeof(column_names) / sizeof(char *)))
+
+static const char *operators[] = {
+	"=", "<>", "<", ">", "<=", ">="
+};
+
+#define NOPERATORS		((int) (sizeof(operators) / sizeof(char *)))
+
+static void
+write_column(FILE *out, int i)
+{
+	fprintf(out, "t%d.%s", random_int(4), column_names[i % NCOLUMN_NAMES]);
+}
+
+/*
+ * Writes simple condition (comparison, LIKE, IS NULL or BETWEEN)
+ */
+static void
+write_condition(FILE *out, int i)
+{
+	switch (random_int(8))
+	{
+		case 0:
+			write_column(out, i);
+			fprintf(out, " LIKE 'abc%d%%'", random_int(1000));
+			break;
+		case 1:
+			write_column(out, i);
+			fprintf(out, " IS NULL");
+			break;
+		case 2:
+			write_column(out, i);
+			fprintf(out, " BETWEEN %d AND %d", random_int(100), 100 + random_int(100));
+			break;
+		default:
+			write_column(out, i);
+			fprintf(out, " %s %d", operators[random_int(NOPERATORS)], random_int(100000));
+	}
+}
+
+static void
+gen_columns(FILE *out, int n)
+{
+	int		i;
+
+	fprintf(out, "SELECT ");
+
+	for (i = 0; i < n; i++)
+	{
+		if (i > 0)
+			fprintf(out, ",\n       ");
+
+		switch (random_int(4))
+		{
+			case 0:
+				write_column(out, i);
+				break;
+			case 1:
+				write_column(out, i);
+				fprintf(out, " + %d AS c%d", random_int(100), i);
+				break;
+			case 2:
+				fprintf(out, "coalesce(");
+				write_column(out, i);
+				fprintf(out, ", 'x') AS c%d", i);
+				break;
+			default:
+				fprintf(out, "c%d", i);
+		}
+	}
+
+	fprintf(out, "\nFROM t0;\n");
+}
+
+static void
+gen_predicate(FILE *out, int n)
+{
+	int		i;
+
+	fprintf(out, "SELECT id FROM t0\nWHERE ");
+
+	for (i = 0; i < n; i++)
+	{
+		if (i > 0)
+			fprintf(out, random_int(3) == 0 ? "\n   OR " : " AND ");
+
+		write_condition(out, i);
+	}
+
+	fprintf(out, ";\n");
+}
+
+static void
+gen_in(FILE *out, int n)
+{
+	int		i;
+
+	fprintf(out, "SELECT id FROM t0\nWHERE id IN (");
+
+	for (i = 0; i < n; i++)
+	{
+		if (i > 0)
+			fprintf(out, (i % 16) == 0 ? ",\n" : ", ");
+
+		fprintf(out, "%d", random_int(10000000));
+	}
+
+	fprintf(out, ");\n");
+}
+
+static void
+gen_join(FILE *out, int n)
+{
+	static const char *jointypes[] = {
+		"JOIN", "LEFT JOIN", "INNER JOIN", "LEFT OUTER JOIN"
+	};
+
+	int		i;
+
+	fprintf(out, "SELECT t0.id, t%d.name\nFROM t0", n);
+
+	for (i = 1; i <= n; i++)
+		fprintf(out, "\n  %s t%d ON t%d.id = t%d.parent_id AND t%d.status = %d",
+				jointypes[random_int(4)], i, i - 1, i, i, random_int(10));
+
+	fprintf(out, "\nWHERE t0.id > %d;\n", random_int(1000));
+}
+
+static void
+gen_nested(FILE *out, int n)
+{
+	int		i;
+
+	for (i = 0; i < n; i++)
+		fprintf(out, "SELECT s%d.id FROM (\n", i);
+
+	fprintf(out, "SELECT id FROM t0 WHERE id > %d", random_int(1000));
+
+	for (i = n - 1; i >= 0; i--)
+		fprintf(out, "\n) s%d WHERE s%d.id <> %d", i, i, random_int(1000));
+
+	fprintf(out, ";\n");
+}
+
+/*
+ * Short queries like from usual application
+ */
+static void
+gen_mixed(FILE *out, long long size)
+{
+	long long	written = 0;
+
+	while (written < size)
+	{
+		int		i;
+		int		n;
+
+		switch (random_int(4))
+		{
+			case 0:
+				written += fprintf(out, "SELECT * FROM t0 WHERE id = %d;\n",
+								   random_int(1000000));
+				break;
+
+			case 1:
+				n = 1 + random_int(8);
+				written += fprintf(out, "SELECT ");
+				for (i = 0; i < n; i++)
+					written += fprintf(out, "%s%s", i > 0 ? ", " : "",
+									   column_names[random_int(NCOLUMN_NAMES)]);
+				written += fprintf(out, " FROM t%d WHERE status = 'active' AND price > %d ORDER BY id DESC LIMIT %d;\n",
+								   random_int(10), random_int(1000), 1 + random_int(100));
+				break;
+
+			case 2:
+				written += fprintf(out, "SELECT t0.id, t1.name, count(t1.id) FROM t0\n"
+										"  LEFT JOIN t1 ON t0.id = t1.customer_id\n"
+										"WHERE t0.created_at > '2020-01-01' AND t1.amount BETWEEN %d AND %d\n"
+										"GROUP BY t0.id, t1.name HAVING count(t1.id) > %d;\n",
+								   random_int(100), 100 + random_int(1000), random_int(10));
+				break;
+
+			default:
+				written += fprintf(out, "SELECT id FROM t0 WHERE customer_id = (SELECT id FROM t1 WHERE name = 'customer %d') OR EXISTS (SELECT 1 FROM t2 WHERE t2.id = t0.id);\n",
+								   random_int(100000));
+		}
+	}
+}
+
+static void
+usage(const char *progname)
+{
+	fprintf(stderr, "Usage: %s [-s seed] [-n count] [-S megabytes] columns|predicate|in|join|nested|mixed\n",
+			progname);
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	const char *shape;
+	long long	megabytes = 64;
+	int			n = 0;
+	int			c;
+
+	random_state = 1;
+
+	while ((c = getopt(argc, argv, "s:n:S:")) != -1)
+	{
+		switch (c)
+		{
+			case 's':
+				random_state = strtoull(optarg, NULL, 10);
+				/* zero state generates only zeros */
+				if (random_state == 0)
+					random_state = 1;
+				break;
+
+			case 'n':
+				n = atoi(optarg);
+				if (n < 1)
+					usage(argv[0]);
+				break;
+
+			case 'S':
+				megabytes = atoll(optarg);
+				if (megabytes < 1)
+					usage(argv[0]);
+				break;
+
+			default:
+				usage(argv[0]);
+		}
+	}
+
+	if (optind != argc - 1)
+		usage(argv[0]);
+
+	shape = argv[optind];
+
+	if (strcmp(shape, "columns") == 0)
+		gen_columns(stdout, n > 0 ? n : 5000);
+	else if (strcmp(shape, "predicate") == 0)
+		gen_predicate(stdout, n > 0 ? n : 10000);
+	else if (strcmp(shape, "in") == 0)
+		gen_in(stdout, n > 0 ? n : 100000);
+	else if (strcmp(shape, "join") == 0)
+		gen_join(stdout, n > 0 ? n : 50);
+	else if (strcmp(shape, "nested") == 0)
+		gen_nested(stdout, n > 0 ? n : 200);
+	else if (strcmp(shape, "mixed") == 0)
+		gen_mixed(stdout, megabytes * 1024 * 1024);
+	else
+		usage(argv[0]);
+
+	if (fflush(stdout) != 0)
+	{
+		fprintf(stderr, "cannot write output\n");
+		exit(1);
+	}
+
+	return 0;
+}
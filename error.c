@@ -0,0 +1,111 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pspretty.h"
+
+/*
+ * Error reporting. The first error of statement is stored in parser
+ * context, and it is printed to stderr, when context is not quiet.
+ * All errors are written to errout of context too, when it is set
+ * (workers of batch collect errors of job there).
+ *
+ * Fatal errors (out of memory, too long input) cannot be returned
+ * through the parser, so they jump to error_jmp of context. Without
+ * error_jmp (in CLI) the process exits. The exceeded budgets of
+ * statement jump to budget_jmp, and only the statement fails.
+ */
+
+/*
+ * The context of running API call. It is used by out_of_memory,
+ * that has not access to parser context.
+ */
+static _Thread_local PsParser *error_context = NULL;
+
+void
+set_error_context(PsParser *ps)
+{
+	error_context = ps;
+}
+
+static void
+store_error(PsParser *ps, PsErrorCode code, const char *fmt, va_list args)
+{
+	char	buffer[sizeof(ps->errmsg)];
+
+	vsnprintf(buffer, sizeof(buffer), fmt, args);
+
+	if (ps->error_code == PS_OK)
+	{
+		ps->error_code = code;
+		snprintf(ps->errmsg, sizeof(ps->errmsg), "%s", buffer);
+	}
+
+	if (ps->errout)
+	{
+		output_str(ps->errout, buffer);
+		output_char(ps->errout, '\n');
+	}
+
+	if (!ps->quiet)
+		fprintf(stderr, "%s\n", buffer);
+}
+
+void
+parser_error(PsParser *ps, PsErrorCode code, const char *fmt, ...)
+{
+	va_list		args;
+
+	va_start(args, fmt);
+	store_error(ps, code, fmt, args);
+	va_end(args);
+}
+
+void
+parser_fatal(PsParser *ps, PsErrorCode code, const char *fmt, ...)
+{
+	va_list		args;
+
+	va_start(args, fmt);
+	store_error(ps, code, fmt, args);
+	va_end(args);
+
+	if (ps->error_jmp)
+		longjmp(*ps->error_jmp, 1);
+
+	exit(1);
+}
+
+/*
+ * Cancels the statement, when some budget of statement is exceeded.
+ * It is not fatal error, only the statement fails, and the parsing
+ * continues by next statement.
+ */
+void
+budget_exceeded(PsParser *ps, PsErrorCode code, const char *fmt, ...)
+{
+	va_list		args;
+
+	va_start(args, fmt);
+	store_error(ps, code, fmt, args);
+	va_end(args);
+
+	longjmp(*ps->budget_jmp, 1);
+}
+
+void
+reset_parser_error(PsParser *ps)
+{
+	ps->error_code = PS_OK;
+	ps->errmsg[0] = '\0';
+}
+
+void
+out_of_memory(void)
+{
+	if (error_context)
+		parser_fatal(error_context, PS_ERROR_OUT_OF_MEMORY, "out of memory");
+
+	fprintf(stderr, "out of memory\n");
+	exit(1);
+}
@@ -0,0 +1,655 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "pspretty.h"
+
+/*
+ * Push style API. The input is passed in chunks of any size, and
+ * the parser is called for every complete statement. Only the last
+ * incomplete statement is held in buffer, so the memory is limited by
+ * the size of largest statement, not by the size of input.
+ *
+ * The statements are separated by statement splitter. It is simple
+ * state machine, that knows only quotes, comments and the tokens, that
+ * can be before comment (it should to know same syntax like the lexer,
+ * else a semicolon inside string or comment can be used as end of
+ * statement). The state is held between
+ * chunks, so tokens can be split by chunk boundary.
+ */
+typedef enum
+{
+	ss_normal,
+	ss_operator,				/* inside operator, comment cannot start there */
+	ss_equal,					/* after '=', it can be "=>" */
+	ss_colon,					/* after ':', it can be ":=" or "::" */
+	ss_dash,					/* after '-', it can be start of comment */
+	ss_slash,					/* after '/', it can be start of comment */
+	ss_squote,					/* inside string */
+	ss_squote_end,				/* after quote inside string */
+	ss_dquote,					/* inside quoted identifier */
+	ss_dquote_end,				/* after double quote inside identifier */
+	ss_line_comment,
+	ss_block_comment,
+	ss_block_comment_star		/* after '*' inside multiline comment */
+} SplitterState;
+
+/*
+ * Same chars like is_operator in tokens.c
+ */
+static bool
+is_operator_char(int c)
+{
+	switch (c)
+	{
+		case '~':
+		case '@':
+		case '%':
+		case '+':
+		case '-':
+		case '*':
+		case '/':
+		case '^':
+		case '?':
+		case '<':
+		case '>':
+		case '=':
+		case '!':
+		case '|':
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Parses all statements from buffer between start and end and
+ * pass them to callback.
+ */
+static void
+process_statements(PsFeeder *f, size_t end)
+{
+	PsParser *ps = f->ps;
+	Node   *node;
+	bool	error;
+
+	if (f->text_callback)
+	{
+		f->text_callback(f->buffer + f->start, end - f->start,
+						 f->start_lineno, f->start_pos,
+						 f->stable, f->callback_arg);
+		return;
+	}
+
+	init_lexer(ps, f->buffer + f->start, end - f->start, f->force8bit);
+
+	/* error messages should to show position in whole stream */
+	ps->line_offset = f->start_lineno;
+	ps->pos_offset = f->start_pos;
+
+	while ((node = parse_next_statement(ps, &error)) || error)
+		f->callback(ps, node, f->callback_arg);
+}
+
+/*
+ * The statement splitter has found end of statement on position pos
+ */
+static void
+statement_end(PsFeeder *f, size_t pos, int lineno, long long line_start)
+{
+	process_statements(f, pos + 1);
+
+	f->start = pos + 1;
+	f->start_lineno = lineno;
+	f->start_pos = (int) ((long long) f->start - line_start);
+}
+
+/*
+ * Scalar statement splitter, process chars from i to end
+ */
+static SplitterState
+scan_chars(PsFeeder *f, SplitterState state, size_t i, size_t end)
+{
+	while (i < end)
+	{
+		int		c = (unsigned char) f->buffer[i];
+
+		switch (state)
+		{
+			case ss_normal:
+				if (c == ';')
+					statement_end(f, i, f->lineno, f->line_start);
+				else if (c == '\'')
+					state = ss_squote;
+				else if (c == '"')
+					state = ss_dquote;
+				else if (c == '=')
+					state = ss_equal;
+				else if (c == ':')
+					state = ss_colon;
+				else if (c == '-')
+					state = ss_dash;
+				else if (c == '/')
+					state = ss_slash;
+				else if (is_operator_char(c))
+					state = ss_operator;
+				break;
+
+			case ss_operator:
+				if (!is_operator_char(c))
+				{
+					/* process this char again in normal state */
+					state = ss_normal;
+					continue;
+				}
+				break;
+
+			case ss_equal:
+				if (c == '>')
+					state = ss_normal;
+				else
+				{
+					state = ss_operator;
+					continue;
+				}
+				break;
+
+			case ss_colon:
+				state = ss_normal;
+
+				/*
+				 * ":=" and "::" are complete tokens, so "--" after them
+				 * starts comment. Else process this char again.
+				 */
+				if (c != '=' && c != ':')
+					continue;
+				break;
+
+			case ss_dash:
+				if (c == '-')
+					state = ss_line_comment;
+				else
+				{
+					state = ss_operator;
+					continue;
+				}
+				break;
+
+			case ss_slash:
+				if (c == '*')
+					state = ss_block_comment;
+				else
+				{
+					state = ss_operator;
+					continue;
+				}
+				break;
+
+			case ss_squote:
+				if (c == '\'')
+					state = ss_squote_end;
+				break;
+
+			case ss_squote_end:
+				if (c == '\'')
+					/* double single quotes */
+					state = ss_squote;
+				else
+				{
+					state = ss_normal;
+					continue;
+				}
+				break;
+
+			case ss_dquote:
+				if (c == '"')
+					state = ss_dquote_end;
+				break;
+
+			case ss_dquote_end:
+				if (c == '"')
+					/* double double quotes */
+					state = ss_dquote;
+				else
+				{
+					state = ss_normal;
+					continue;
+				}
+				break;
+
+			case ss_line_comment:
+				if (c == '\n')
+					state = ss_normal;
+				break;
+
+			case ss_block_comment:
+				if (c == '*')
+					state = ss_block_comment_star;
+				break;
+
+			case ss_block_comment_star:
+				if (c == '/')
+					state = ss_normal;
+				else if (c != '*')
+					state = ss_block_comment;
+				break;
+		}
+
+		if (c == '\n')
+		{
+			f->lineno += 1;
+			f->line_start = (long long) i + 1;
+		}
+
+		i += 1;
+	}
+
+	return state;
+}
+
+/******************************************************
+ *
+ *  Structural index
+ *
+ *  Blocks of 64 bytes are classified together. The bitmaps
+ *  of quotes, semicolons, comment starts and new lines are
+ *  calculated by SIMD instructions, and the regions inside
+ *  quotes are calculated from bitmap of quotes by prefix xor
+ *  (carry-less multiplication by all ones). The doubled quotes
+ *  inside string toggle the state twice, so they don't need
+ *  special care.
+ *
+ *  When the block contains chars that can start comment
+ *  outside quotes, or both kinds of quotes, then the block
+ *  is processed by scalar splitter.
+ *
+ ******************************************************/
+
+#define BLOCK_SIZE			64
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define VEC_WIDTH			32
+
+typedef __m256i vec;
+
+#define vec_load(p)			_mm256_loadu_si256((const __m256i *) (p))
+#define vec_set1(c)			_mm256_set1_epi8(c)
+#define vec_eq(a, b)		_mm256_cmpeq_epi8(a, b)
+#define vec_or(a, b)		_mm256_or_si256(a, b)
+#define vec_mask(a)			((uint64_t) (uint32_t) _mm256_movemask_epi8(a))
+
+#elif defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#define VEC_WIDTH			16
+
+typedef __m128i vec;
+
+#define vec_load(p)			_mm_loadu_si128((const __m128i *) (p))
+#define vec_set1(c)			_mm_set1_epi8(c)
+#define vec_eq(a, b)		_mm_cmpeq_epi8(a, b)
+#define vec_or(a, b)		_mm_or_si128(a, b)
+#define vec_mask(a)			((uint64_t) (uint16_t) _mm_movemask_epi8(a))
+
+#endif
+
+#if defined(__PCLMUL__)
+
+#include <wmmintrin.h>
+
+#endif
+
+typedef struct
+{
+	uint64_t	squote;
+	uint64_t	dquote;
+	uint64_t	semicolon;
+	uint64_t	comment;		/* '-' or '/' */
+	uint64_t	newline;
+} BlockMasks;
+
+static void
+block_masks(const char *p, BlockMasks *m)
+{
+#ifdef VEC_WIDTH
+
+	int		i;
+
+	memset(m, 0, sizeof(BlockMasks));
+
+	for (i = 0; i < BLOCK_SIZE; i += VEC_WIDTH)
+	{
+		vec		x = vec_load(p + i);
+
+		m->squote |= vec_mask(vec_eq(x, vec_set1('\''))) << i;
+		m->dquote |= vec_mask(vec_eq(x, vec_set1('"'))) << i;
+		m->semicolon |= vec_mask(vec_eq(x, vec_set1(';'))) << i;
+		m->comment |= vec_mask(vec_or(vec_eq(x, vec_set1('-')),
+									  vec_eq(x, vec_set1('/')))) << i;
+		m->newline |= vec_mask(vec_eq(x, vec_set1('\n'))) << i;
+	}
+
+#else
+
+	int		i;
+
+	memset(m, 0, sizeof(BlockMasks));
+
+	for (i = 0; i < BLOCK_SIZE; i++)
+	{
+		uint64_t	bit = (uint64_t) 1 << i;
+
+		switch (p[i])
+		{
+			case '\'':
+				m->squote |= bit;
+				break;
+			case '"':
+				m->dquote |= bit;
+				break;
+			case ';':
+				m->semicolon |= bit;
+				break;
+			case '-':
+			case '/':
+				m->comment |= bit;
+				break;
+			case '\n':
+				m->newline |= bit;
+				break;
+		}
+	}
+
+#endif
+}
+
+/*
+ * Every bit of result is xor of all lower (and same) bits of x
+ */
+static inline uint64_t
+prefix_xor(uint64_t x)
+{
+#if defined(__PCLMUL__)
+
+	__m128i		r = _mm_clmulepi64_si128(_mm_set_epi64x(0, (long long) x),
+										 _mm_set1_epi8((char) 0xff), 0);
+
+	return (uint64_t) _mm_cvtsi128_si64(r);
+
+#else
+
+	x ^= x << 1;
+	x ^= x << 2;
+	x ^= x << 4;
+	x ^= x << 8;
+	x ^= x << 16;
+	x ^= x << 32;
+
+	return x;
+
+#endif
+}
+
+/*
+ * Returns true when the state can be processed by scan_block
+ */
+static inline bool
+is_block_state(SplitterState state)
+{
+	/* after closing quote, next quote starts quoted text again */
+	return state == ss_normal ||
+		   state == ss_squote || state == ss_squote_end ||
+		   state == ss_dquote || state == ss_dquote_end;
+}
+
+/*
+ * Process block of 64 bytes from position i. Returns false, when
+ * the block cannot be processed by bitmaps.
+ */
+static bool
+scan_block(PsFeeder *f, SplitterState *state, size_t i)
+{
+	const char *p = f->buffer + i;
+	BlockMasks	m;
+	uint64_t	quotes;
+	uint64_t	inside;
+	uint64_t	semicolons;
+	bool		squote;
+
+	block_masks(p, &m);
+
+	if (*state == ss_squote || *state == ss_dquote)
+	{
+		squote = *state == ss_squote;
+
+		/* other kind of quotes can be anywhere */
+		if (squote ? m.dquote : m.squote)
+			return false;
+	}
+	else
+	{
+		/* both kinds of quotes should be processed sequentially */
+		if (m.squote && m.dquote)
+			return false;
+
+		squote = m.squote != 0;
+	}
+
+	quotes = squote ? m.squote : m.dquote;
+	inside = prefix_xor(quotes);
+
+	if (*state == ss_squote || *state == ss_dquote)
+		inside = ~inside;
+
+	/* comment can start outside quotes */
+	if (m.comment & ~inside)
+		return false;
+
+	/*
+	 * Operator or ':' at the end of block can continue in next block,
+	 * and comment cannot start inside operator or just after ":=".
+	 */
+	if (!(inside >> (BLOCK_SIZE - 1)) &&
+		(is_operator_char((unsigned char) p[BLOCK_SIZE - 1]) ||
+		 p[BLOCK_SIZE - 1] == ':'))
+		return false;
+
+	semicolons = m.semicolon & ~inside;
+
+	while (semicolons)
+	{
+		int			pos = __builtin_ctzll(semicolons);
+		uint64_t	below = ((uint64_t) 1 << pos) - 1;
+		uint64_t	nl = m.newline & below;
+		long long	line_start = f->line_start;
+
+		if (nl)
+			line_start = (long long) i + 64 - __builtin_clzll(nl);
+
+		statement_end(f, i + pos,
+					  f->lineno + __builtin_popcountll(nl),
+					  line_start);
+
+		semicolons &= semicolons - 1;
+	}
+
+	if (m.newline)
+	{
+		f->lineno += __builtin_popcountll(m.newline);
+		f->line_start = (long long) i + 64 - __builtin_clzll(m.newline);
+	}
+
+	if (inside >> (BLOCK_SIZE - 1))
+		*state = squote ? ss_squote : ss_dquote;
+	else
+		*state = ss_normal;
+
+	return true;
+}
+
+/*
+ * Searchs ends of statements in not scanned part of buffer, and
+ * process complete statements. The blocks without comments are
+ * processed by structural index, other by scalar splitter.
+ */
+static void
+split_statements(PsFeeder *f)
+{
+	SplitterState state = f->state;
+	size_t	i = f->scanned;
+
+	while (i < f->used)
+	{
+		if (!is_block_state(state))
+		{
+			/* scalar splitter to state, that can be used by scan_block */
+			state = scan_chars(f, state, i, i + 1);
+			i += 1;
+		}
+		else if (i + BLOCK_SIZE <= f->used && scan_block(f, &state, i))
+			i += BLOCK_SIZE;
+		else
+		{
+			size_t	end = i + BLOCK_SIZE <= f->used ? i + BLOCK_SIZE : f->used;
+
+			state = scan_chars(f, state, i, end);
+			i = end;
+		}
+	}
+
+	f->state = state;
+	f->scanned = i;
+}
+
+/*
+ * Initialize feeder. The callback is called for every statement
+ * with parsed node (or NULL, when there is syntax error). The nodes
+ * and the input referenced by nodes are valid only inside callback.
+ */
+void
+init_feeder(PsFeeder *f, PsParser *ps, bool force8bit,
+			PsStatementCallback callback, void *callback_arg)
+{
+	memset(f, 0, sizeof(PsFeeder));
+
+	f->ps = ps;
+	f->force8bit = force8bit;
+	f->callback = callback;
+	f->callback_arg = callback_arg;
+	f->state = ss_normal;
+}
+
+/*
+ * Initialize feeder, that only splits input to statements. The text of
+ * every statement is passed to callback.
+ */
+void
+init_feeder_text(PsFeeder *f, PsTextCallback callback, void *callback_arg)
+{
+	memset(f, 0, sizeof(PsFeeder));
+
+	f->text_callback = callback;
+	f->callback_arg = callback_arg;
+	f->state = ss_normal;
+}
+
+/*
+ * Appends chunk of input. All statements completed by this chunk
+ * are parsed, and the rest of input is moved to start of buffer.
+ */
+void
+feed_input(PsFeeder *f, const char *data, size_t len)
+{
+	char   *buffer;
+
+	if (f->used + len > f->size)
+	{
+		size_t	size = f->size > 0 ? f->size : 64 * 1024;
+
+		while (size < f->used + len)
+			size *= 2;
+
+		buffer = realloc(f->buffer, size);
+		if (!buffer)
+			out_of_memory();
+
+		f->buffer = buffer;
+		f->size = size;
+	}
+
+	memcpy(f->buffer + f->used, data, len);
+	f->used += len;
+
+	split_statements(f);
+
+	/* only incomplete statement is held in buffer */
+	if (f->start > 0)
+	{
+		memmove(f->buffer, f->buffer + f->start, f->used - f->start);
+
+		f->used -= f->start;
+		f->scanned -= f->start;
+		f->line_start -= (long long) f->start;
+		f->start = 0;
+	}
+}
+
+/*
+ * Parses the rest of input (last statement can be without semicolon).
+ */
+void
+finish_feed(PsFeeder *f)
+{
+	if (f->used > f->start)
+		process_statements(f, f->used);
+
+	/* feeder can be used for next stream */
+	f->used = f->scanned = f->start = 0;
+	f->state = ss_normal;
+	f->lineno = f->start_lineno = f->start_pos = 0;
+	f->line_start = 0;
+}
+
+/*
+ * Process whole input (like feed_input and finish_feed), but the input
+ * is not copied to buffer. Passed text of statements is stable, it is
+ * part of input.
+ */
+void
+feed_whole_input(PsFeeder *f, const char *str, size_t len)
+{
+	char   *buffer = f->buffer;
+	size_t	size = f->size;
+
+	/* some data are in buffer already */
+	if (f->used > 0)
+	{
+		feed_input(f, str, len);
+		finish_feed(f);
+		return;
+	}
+
+	f->buffer = (char *) str;
+	f->size = f->used = len;
+	f->stable = true;
+
+	split_statements(f);
+	finish_feed(f);
+
+	f->buffer = buffer;
+	f->size = size;
+	f->stable = false;
+}
+
+void
+free_feeder(PsFeeder *f)
+{
+	free(f->buffer);
+
+	memset(f, 0, sizeof(PsFeeder));
+}
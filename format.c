@@ -0,0 +1,926 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "pspretty.h"
+
+/*
+ * SQL formatter. Keywords are written in requested case, all other
+ * text (identifiers, literals, operators) is written like in input.
+ * Every clause of query is on separate line, the joined relations are
+ * on separate lines below first relation, and ON clause is below
+ * joined relation.
+ *
+ *   SELECT a, b + 1 AS c
+ *   FROM t
+ *       INNER JOIN u
+ *           ON t.id = u.id
+ *   WHERE a > 10
+ *   ORDER BY a DESC;
+ *
+ * Lists and chains of AND/OR are written on one line when they fit
+ * to line width, else they are broken. The formatting is done in two
+ * passes. First pass computes flat width (width of expression written
+ * on one line) of every node bottom-up, and stores it in node. Second
+ * pass writes the output, and the decisions about line breaks are
+ * done by comparing stored flat width with free space on current
+ * line. So every node is visited only twice, and the nested
+ * expressions are not measured again and again.
+ *
+ *   SELECT a, b
+ *   FROM t
+ *   WHERE a IN (1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+ *           16, 17, 18)
+ *       AND b = 1
+ *       AND c = 2;
+ */
+
+/*
+ * Width of expressions, that cannot be written on one line
+ * (subqueries, joins).
+ */
+#define FORMAT_WIDTH_BREAK		(1 << 28)
+
+typedef struct
+{
+	PsOutput   *out;
+	PsFormatOptions *opts;
+	int			column;			/* width of current line */
+} FormatState;
+
+static void format_expr(FormatState *fs, Node *node, int indent);
+static void format_query(FormatState *fs, Node *node, int indent);
+static void format_relation(FormatState *fs, Node *node, int indent);
+
+/*
+ * Returns number of characters of UTF8 string (the continuation
+ * bytes are not counted).
+ */
+static int
+text_width(const char *str, int bytes)
+{
+	int		width = 0;
+	int		i;
+
+	for (i = 0; i < bytes; i++)
+		if ((str[i] & 0xC0) != 0x80)
+			width += 1;
+
+	return width;
+}
+
+/*
+ * Sum of widths, the result is not higher than FORMAT_WIDTH_BREAK
+ */
+static int
+add_width(int a, int b)
+{
+	return a + b < FORMAT_WIDTH_BREAK ? a + b : FORMAT_WIDTH_BREAK;
+}
+
+static int measure_node(Node *node);
+
+static int
+measure_qident(Node *node)
+{
+	int		width = 0;
+
+	while (node)
+	{
+		width = add_width(width, text_width(node->str, node->bytes));
+
+		node = node->other;
+		if (node)
+			width = add_width(width, 1);
+	}
+
+	return width;
+}
+
+/*
+ * Width of literal array, the items have not own nodes
+ */
+static int
+measure_literal_array(Node *node)
+{
+	int		width = 0;
+	int		i;
+
+	for (i = 0; i < node->nargs; i++)
+	{
+		if (i > 0)
+			width = add_width(width, 2);
+
+		width = add_width(width, text_width(node->str + node->literals[i].offset,
+											node->literals[i].bytes));
+	}
+
+	node->width = width;
+
+	return width;
+}
+
+static int
+measure_list(Node *node)
+{
+	Node   *head = node;
+	int		width = 0;
+
+	/* the list of constants can be packed */
+	if (node && node->type == n_literal_array)
+		return measure_literal_array(node);
+
+	while (node)
+	{
+		width = add_width(width, measure_node(node->value));
+
+		node = node->other;
+		if (node)
+			width = add_width(width, 2);
+	}
+
+	if (head)
+		head->width = width;
+
+	return width;
+}
+
+/*
+ * Computes flat width of node and of all nested nodes. The width is
+ * stored in node. Keep it in sync with format_expr.
+ */
+static int
+measure_node(Node *node)
+{
+	Node   *rel;
+	int		width = 0;
+
+	if (!node)
+		return 0;
+
+	if (node->type != n_join && node->type != n_query)
+	{
+		if (node->negate)
+			width += 4;
+		if (node->negative)
+			width += 1;
+	}
+
+	switch (node->type)
+	{
+		case n_numeric:
+		case n_string:
+		case n_null:
+		case n_false:
+		case n_true:
+		case n_named_expr:
+			width = add_width(width, text_width(node->str, node->bytes));
+			if (node->type == n_named_expr)
+				width = add_width(width, 4 + measure_node(node->value));
+			break;
+
+		case n_ident:
+		case n_star:
+			width = add_width(width, measure_qident(node));
+			break;
+
+		case n_function:
+			width = add_width(width, measure_qident(node->other) + 2);
+			width = add_width(width, measure_list(node->value));
+			break;
+
+		case n_labeled_expr:
+			width = add_width(width, measure_node(node->value) + 4);
+			width = add_width(width, text_width(node->str, node->bytes));
+			break;
+
+		case n_composite:
+			width = add_width(width, measure_list(node->value) + 2);
+			break;
+
+		case n_list:
+			/* the width of list is stored in first cell by measure_list */
+			return add_width(width, measure_list(node));
+
+		case n_literal_array:
+			return add_width(width, measure_literal_array(node));
+
+		case n_array:
+			if (node->str)
+				width = add_width(width, 5);
+			width = add_width(width, measure_list(node->value) + 2);
+			break;
+
+		case n_values:
+			width = add_width(width, 7 + measure_list(node->value));
+			break;
+
+		case n_is:
+			width = add_width(width, measure_node(node->value));
+			width = add_width(width, node->is_not ? 8 : 4);
+			width = add_width(width, node->bytes);
+			break;
+
+		case n_is_null:
+		case n_is_not_null:
+			width = add_width(width, measure_node(node->value));
+			width = add_width(width, node->type == n_is_null ? 8 : 12);
+			break;
+
+		case n_expr:
+		case n_logical_and:
+		case n_logical_or:
+		case n_expr_wrapper:
+			if (node->parenthesis)
+				width += 2;
+
+			if (node->type == n_logical_and || node->type == n_logical_or)
+			{
+				int		i;
+
+				for (i = 0; i < node->nargs; i++)
+				{
+					if (i > 0)
+						width = add_width(width, node->type == n_logical_and ? 5 : 4);
+					width = add_width(width, measure_node(node->args[i]));
+				}
+			}
+			else if ((node->type == n_expr_wrapper || !node->other) &&
+					 node->value->type == n_query)
+			{
+				/* subquery and EXISTS (subquery) */
+				measure_node(node->value);
+				width = FORMAT_WIDTH_BREAK;
+			}
+			else
+			{
+				width = add_width(width, measure_node(node->value));
+
+				if (node->type == n_expr_wrapper)
+					;
+				else if (node->exprtype == expr_like)
+					width = add_width(width, 6 + measure_node(node->other));
+				else if (node->exprtype == expr_ilike)
+					width = add_width(width, 7 + measure_node(node->other));
+				else if (node->exprtype == expr_in)
+					width = add_width(width, 4 + measure_node(node->other));
+				else if (node->exprtype == expr_not_in)
+					width = add_width(width, 8 + measure_node(node->other));
+				else if (node->exprtype == expr_between)
+				{
+					width = add_width(width, 9 + measure_node(node->other->value));
+					width = add_width(width, 5 + measure_node(node->other->other));
+				}
+				else
+				{
+					Node   *op = node;
+
+					/*
+					 * Long chain of generic operators is measured by loop. The
+					 * width of inner nodes of chain is not stored, it is not used.
+					 */
+					for (;;)
+					{
+						width = add_width(width, 2 + text_width(op->str, op->bytes));
+						if (!is_operator_chain(op->other))
+							break;
+
+						op = op->other;
+						width = add_width(width, measure_node(op->value));
+					}
+
+					width = add_width(width, measure_node(op->other));
+				}
+			}
+
+			if (node->asc)
+				width = add_width(width, 4);
+			if (node->desc)
+				width = add_width(width, 5);
+			if (node->nulls_first)
+				width = add_width(width, 12);
+			if (node->nulls_last)
+				width = add_width(width, 11);
+			break;
+
+		case n_query:
+			measure_node(node->columns);
+			measure_node(node->where);
+			measure_node(node->group_by);
+			measure_node(node->having);
+			measure_node(node->order_by);
+			measure_node(node->limit);
+			measure_node(node->offset);
+
+			for (rel = node->from; rel; rel = rel->other)
+				measure_node(rel->value);
+
+			width = FORMAT_WIDTH_BREAK;
+			break;
+
+		case n_join:
+			measure_node(node->left);
+			measure_node(node->right);
+			measure_node(node->onexpr);
+			measure_list(node->using);
+
+			width = FORMAT_WIDTH_BREAK;
+			break;
+	}
+
+	node->width = width;
+
+	return width;
+}
+
+/*
+ * Returns true, when the text of width can be written to current line
+ */
+static bool
+format_fits(FormatState *fs, int width)
+{
+	return fs->column + width <= fs->opts->line_width;
+}
+
+static void
+format_write(FormatState *fs, const char *str, int bytes)
+{
+	output_write(fs->out, str, bytes);
+	fs->column += text_width(str, bytes);
+}
+
+static void
+format_char(FormatState *fs, char c)
+{
+	output_char(fs->out, c);
+	fs->column += 1;
+}
+
+static void
+format_str(FormatState *fs, const char *str)
+{
+	format_write(fs, str, strlen(str));
+}
+
+/*
+ * Writes keyword in requested case. The keyword can be passed in
+ * any case (it can be keyword from input).
+ */
+static void
+format_keyword_str(FormatState *fs, const char *str, int bytes)
+{
+	fs->column += bytes;
+
+	while (bytes > 0)
+	{
+		char	buffer[64];
+		int		n = bytes < 64 ? bytes : 64;
+		int		i;
+
+		for (i = 0; i < n; i++)
+		{
+			char	c = str[i];
+
+			if (fs->opts->keyword_case == kc_lower)
+			{
+				if (c >= 'A' && c <= 'Z')
+					c += 'a' - 'A';
+			}
+			else
+			{
+				if (c >= 'a' && c <= 'z')
+					c -= 'a' - 'A';
+			}
+
+			buffer[i] = c;
+		}
+
+		output_write(fs->out, buffer, n);
+
+		str += n;
+		bytes -= n;
+	}
+}
+
+static void
+format_keyword(FormatState *fs, const char *keyword)
+{
+	format_keyword_str(fs, keyword, strlen(keyword));
+}
+
+/*
+ * Starts new line with indentation
+ */
+static void
+format_newline(FormatState *fs, int indent)
+{
+	output_char(fs->out, '\n');
+	output_indent(fs->out, indent * fs->opts->indent_width);
+
+	fs->column = indent * fs->opts->indent_width;
+}
+
+static void
+format_qident(FormatState *fs, Node *node)
+{
+	while (node)
+	{
+		format_write(fs, node->str, node->bytes);
+
+		node = node->other;
+		if (node)
+			format_char(fs, '.');
+	}
+}
+
+/*
+ * Subquery is always in parenthesis on separate lines
+ */
+static void
+format_subquery(FormatState *fs, Node *node, int indent)
+{
+	format_char(fs, '(');
+	format_newline(fs, indent + 1);
+	format_query(fs, node, indent + 1);
+	format_newline(fs, indent);
+	format_char(fs, ')');
+}
+
+/*
+ * Writes items of literal array like format_list
+ */
+static void
+format_literal_array(FormatState *fs, Node *node, int indent, bool fill)
+{
+	bool	broken = !format_fits(fs, node->width);
+	int		i;
+
+	for (i = 0; i < node->nargs; i++)
+	{
+		Literal    *literal = &node->literals[i];
+		char	   *str = node->str + literal->offset;
+
+		if (i > 0)
+		{
+			format_char(fs, ',');
+			if (broken &&
+				(!fill || !format_fits(fs, text_width(str, literal->bytes) + 2)))
+				format_newline(fs, indent + 1);
+			else
+				format_char(fs, ' ');
+		}
+
+		if (literal->type == n_numeric || literal->type == n_string)
+			format_write(fs, str, literal->bytes);
+		else
+			format_keyword_str(fs, str, literal->bytes);
+	}
+}
+
+/*
+ * Writes list on one line, when it fits. Else every item is on
+ * separate line, or when fill is true, the items are written to
+ * line, while they fit.
+ */
+static void
+format_list(FormatState *fs, Node *node, int indent, bool fill)
+{
+	bool	broken;
+
+	if (!node)
+		return;
+
+	if (node->type == n_literal_array)
+	{
+		format_literal_array(fs, node, indent, fill);
+		return;
+	}
+
+	broken = !format_fits(fs, node->width);
+
+	while (node)
+	{
+		format_expr(fs, node->value, broken ? indent + 1 : indent);
+
+		node = node->other;
+		if (node)
+		{
+			format_char(fs, ',');
+
+			/* one char is reserved for comma or parenthesis */
+			if (broken &&
+				(!fill || !format_fits(fs, node->value->width + 2)))
+				format_newline(fs, indent + 1);
+			else
+				format_char(fs, ' ');
+		}
+	}
+}
+
+static void
+format_logical_operator(FormatState *fs, NodeType type, int indent, bool broken)
+{
+	if (broken)
+	{
+		format_newline(fs, indent + 1);
+		format_keyword(fs, type == n_logical_and ? "AND " : "OR ");
+	}
+	else
+		format_keyword(fs, type == n_logical_and ? " AND " : " OR ");
+}
+
+/*
+ * Writes chain of AND or OR operators. When the chain doesn't fit
+ * to line, then every operand (except first) is on separate line.
+ */
+static void
+format_logical(FormatState *fs, Node *node, int indent, bool broken)
+{
+	int		i;
+
+	for (i = 0; i < node->nargs; i++)
+	{
+		if (i > 0)
+			format_logical_operator(fs, node->type, indent, broken);
+		format_expr(fs, node->args[i], broken ? indent + 1 : indent);
+	}
+}
+
+/*
+ * Formats the operator of expression node and right operand
+ */
+static void
+format_operator(FormatState *fs, Node *node, int indent)
+{
+	if (node->exprtype == expr_like)
+	{
+		format_keyword(fs, " LIKE ");
+		format_expr(fs, node->other, indent);
+	}
+	else if (node->exprtype == expr_ilike)
+	{
+		format_keyword(fs, " ILIKE ");
+		format_expr(fs, node->other, indent);
+	}
+	else if (node->exprtype == expr_in || node->exprtype == expr_not_in)
+	{
+		format_keyword(fs, node->exprtype == expr_in ? " IN " : " NOT IN ");
+		format_expr(fs, node->other, indent);
+	}
+	else if (node->exprtype == expr_between)
+	{
+		/* the bounds are in other node (AND node) */
+		format_keyword(fs, " BETWEEN ");
+		format_expr(fs, node->other->value, indent);
+		format_keyword(fs, " AND ");
+		format_expr(fs, node->other->other, indent);
+	}
+	else
+	{
+		/* long chain of generic operators is written by loop */
+		for (;;)
+		{
+			format_char(fs, ' ');
+			format_write(fs, node->str, node->bytes);
+			format_char(fs, ' ');
+
+			if (!is_operator_chain(node->other))
+				break;
+
+			node = node->other;
+			format_expr(fs, node->value, indent);
+		}
+
+		format_expr(fs, node->other, indent);
+	}
+}
+
+static void
+format_expr(FormatState *fs, Node *node, int indent)
+{
+	if (!node)
+		return;
+
+	if (node->type != n_join && node->type != n_query)
+	{
+		if (node->negate)
+			format_keyword(fs, "NOT ");
+		if (node->negative)
+			format_char(fs, '-');
+	}
+
+	switch (node->type)
+	{
+		case n_numeric:
+		case n_string:
+			format_write(fs, node->str, node->bytes);
+			break;
+
+		case n_null:
+		case n_false:
+		case n_true:
+			format_keyword_str(fs, node->str, node->bytes);
+			break;
+
+		case n_ident:
+		case n_star:
+			format_qident(fs, node);
+			break;
+
+		case n_function:
+			format_qident(fs, node->other);
+			format_char(fs, '(');
+			format_list(fs, node->value, indent, true);
+			format_char(fs, ')');
+			break;
+
+		case n_named_expr:
+			format_write(fs, node->str, node->bytes);
+			format_str(fs, " => ");
+			format_expr(fs, node->value, indent);
+			break;
+
+		case n_labeled_expr:
+			format_expr(fs, node->value, indent);
+			format_keyword(fs, " AS ");
+			format_write(fs, node->str, node->bytes);
+			break;
+
+		case n_composite:
+			format_char(fs, '(');
+			format_list(fs, node->value, indent, true);
+			format_char(fs, ')');
+			break;
+
+		case n_list:
+			format_list(fs, node, indent, false);
+			break;
+
+		case n_literal_array:
+			format_literal_array(fs, node, indent, true);
+			break;
+
+		case n_array:
+			if (node->str)
+				format_keyword(fs, "ARRAY");
+			format_char(fs, '[');
+			format_list(fs, node->value, indent, true);
+			format_char(fs, ']');
+			break;
+
+		case n_values:
+			format_keyword(fs, "VALUES ");
+			format_list(fs, node->value, indent, false);
+			break;
+
+		case n_is:
+			format_expr(fs, node->value, indent);
+			format_keyword(fs, node->is_not ? " IS NOT " : " IS ");
+			format_keyword_str(fs, node->str, node->bytes);
+			break;
+
+		case n_is_null:
+			format_expr(fs, node->value, indent);
+			format_keyword(fs, " IS NULL");
+			break;
+
+		case n_is_not_null:
+			format_expr(fs, node->value, indent);
+			format_keyword(fs, " IS NOT NULL");
+			break;
+
+		case n_expr:
+		case n_logical_and:
+		case n_logical_or:
+		case n_expr_wrapper:
+			if (node->type == n_expr_wrapper && node->value->type == n_query)
+			{
+				/* subquery is in parenthesis always */
+				format_subquery(fs, node->value, indent);
+			}
+			else
+			{
+				if (node->parenthesis)
+					format_char(fs, '(');
+
+				if (node->type == n_expr && !node->other &&
+					node->value->type == n_query)
+				{
+					/* EXISTS (subquery) */
+					format_keyword(fs, "EXISTS ");
+					format_subquery(fs, node->value, indent);
+				}
+				else if (node->type == n_logical_and ||
+						 node->type == n_logical_or)
+				{
+					int		width = node->width;
+
+					/* the prefix is written already */
+					if (node->negate)
+						width -= 4;
+					if (node->negative)
+						width -= 1;
+
+					format_logical(fs, node, indent, !format_fits(fs, width));
+				}
+				else
+				{
+					format_expr(fs, node->value, indent);
+
+					if (node->type != n_expr_wrapper)
+						format_operator(fs, node, indent);
+				}
+
+				if (node->parenthesis)
+					format_char(fs, ')');
+			}
+
+			/* ORDER BY flags */
+			if (node->asc)
+				format_keyword(fs, " ASC");
+			if (node->desc)
+				format_keyword(fs, " DESC");
+			if (node->nulls_first)
+				format_keyword(fs, " NULLS FIRST");
+			if (node->nulls_last)
+				format_keyword(fs, " NULLS LAST");
+			break;
+
+		case n_query:
+			format_subquery(fs, node, indent);
+			break;
+
+		case n_join:
+			format_relation(fs, node, indent);
+			break;
+	}
+}
+
+static void
+format_join_type(FormatState *fs, Node *node)
+{
+	if (node->is_natural)
+		format_keyword(fs, "NATURAL ");
+
+	switch (node->jointype)
+	{
+		case k_JOIN:
+		case k_INNER_JOIN:
+			format_keyword(fs, "INNER JOIN ");
+			break;
+		case k_CROSS_JOIN:
+			format_keyword(fs, "CROSS JOIN ");
+			break;
+		case k_LEFT_OUTER_JOIN:
+			format_keyword(fs, "LEFT OUTER JOIN ");
+			break;
+		case k_RIGHT_OUTER_JOIN:
+			format_keyword(fs, "RIGHT OUTER JOIN ");
+			break;
+		case k_FULL_OUTER_JOIN:
+			format_keyword(fs, "FULL OUTER JOIN ");
+			break;
+		default:
+			break;
+	}
+}
+
+/*
+ * Formats item of FROM clause. The joined relations are on separate
+ * lines with higher indentation.
+ */
+static void
+format_relation(FormatState *fs, Node *node, int indent)
+{
+	switch (node->type)
+	{
+		case n_join:
+			if (node->relexpr_parenthesis)
+			{
+				format_char(fs, '(');
+				format_newline(fs, indent + 1);
+				indent += 1;
+			}
+
+			format_relation(fs, node->left, indent);
+
+			format_newline(fs, indent + 1);
+			format_join_type(fs, node);
+			format_relation(fs, node->right, indent + 1);
+
+			if (node->onexpr)
+			{
+				format_newline(fs, indent + 2);
+				format_keyword(fs, "ON ");
+				format_expr(fs, node->onexpr, indent + 2);
+			}
+			else if (node->using)
+			{
+				format_keyword(fs, " USING ");
+				format_char(fs, '(');
+				format_list(fs, node->using, indent + 1, true);
+				format_char(fs, ')');
+			}
+
+			if (node->relexpr_parenthesis)
+			{
+				format_newline(fs, indent - 1);
+				format_char(fs, ')');
+			}
+			break;
+
+		case n_labeled_expr:
+			format_relation(fs, node->value, indent);
+			format_keyword(fs, " AS ");
+			format_write(fs, node->str, node->bytes);
+			break;
+
+		case n_query:
+			format_subquery(fs, node, indent);
+			break;
+
+		default:
+			format_expr(fs, node, indent);
+	}
+}
+
+static void
+format_clause(FormatState *fs, const char *keyword, Node *node, int indent)
+{
+	if (!node)
+		return;
+
+	format_newline(fs, indent);
+	format_keyword(fs, keyword);
+	format_expr(fs, node, indent);
+}
+
+static void
+format_query(FormatState *fs, Node *node, int indent)
+{
+	if (node->columns && node->columns->type == n_values)
+		format_expr(fs, node->columns, indent);
+	else
+	{
+		format_keyword(fs, "SELECT");
+		if (node->columns)
+		{
+			format_char(fs, ' ');
+			format_list(fs, node->columns, indent, false);
+		}
+	}
+
+	if (node->from)
+	{
+		Node   *rel;
+
+		format_newline(fs, indent);
+		format_keyword(fs, "FROM ");
+
+		for (rel = node->from; rel; rel = rel->other)
+		{
+			format_relation(fs, rel->value, indent);
+			if (rel->other)
+				format_str(fs, ", ");
+		}
+	}
+
+	format_clause(fs, "WHERE ", node->where, indent);
+	format_clause(fs, "GROUP BY ", node->group_by, indent);
+	format_clause(fs, "HAVING ", node->having, indent);
+	format_clause(fs, "ORDER BY ", node->order_by, indent);
+	format_clause(fs, "LIMIT ", node->limit, indent);
+	format_clause(fs, "OFFSET ", node->offset, indent);
+}
+
+/*
+ * Set default format options
+ */
+void
+init_format_options(PsFormatOptions *opts)
+{
+	opts->keyword_case = kc_upper;
+	opts->indent_width = 4;
+	opts->line_width = 80;
+}
+
+/*
+ * Writes formatted statement closed by semicolon to output
+ */
+void
+format_statement(PsOutput *out, Node *node, PsFormatOptions *opts)
+{
+	FormatState fs;
+
+	fs.out = out;
+	fs.opts = opts;
+	fs.column = 0;
+
+	measure_node(node);
+
+	if (node->type == n_query)
+		format_query(&fs, node, 0);
+	else
+		format_expr(&fs, node, 0);
+
+	output_str(out, ";\n");
+}
@@ -0,0 +1,150 @@
+/*
+ * Generates perfect hash function for keywords from kwlist.h
+ *
+ * Usage: gen_keywords > kwlist_d.h
+ *
+ * The hash is computed from length of keyword and from first, second
+ * and last char (only five low bits of char are used, so the hash is
+ * case insensitive for ASCII letters). The generator searches weights
+ * of chars, so every keyword has its own slot in hash table. The
+ * keywords with more words cannot be in input identifier, and then
+ * they are not in the hash table.
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+	const char *name;
+	const char *value;
+	int			len;
+} KeywordDesc;
+
+#define PS_KEYWORD(name, value, reserved)		{ name, #value, sizeof(name) - 1 },
+
+static KeywordDesc keywords[] = {
+#include "kwlist.h"
+};
+
+#undef PS_KEYWORD
+
+#define NKEYWORDS		((int) (sizeof(keywords) / sizeof(KeywordDesc)))
+#define HASH_SIZE		128
+#define MAX_ATTEMPTS	1000000
+
+static int	asso[32];
+static int	table[HASH_SIZE];
+
+static bool
+is_single_word(KeywordDesc *kd)
+{
+	int		i;
+
+	for (i = 0; i < kd->len; i++)
+		if (kd->name[i] < 'a' || kd->name[i] > 'z')
+			return false;
+
+	return true;
+}
+
+static int
+hash(KeywordDesc *kd)
+{
+	const char *str = kd->name;
+	int		len = kd->len;
+
+	return (len + asso[str[0] & 0x1f] + asso[str[1] & 0x1f] + asso[str[len - 1] & 0x1f]) & (HASH_SIZE - 1);
+}
+
+/*
+ * Returns true, when current weights produce perfect hash
+ */
+static bool
+try_weights()
+{
+	int		i;
+
+	for (i = 0; i < HASH_SIZE; i++)
+		table[i] = -1;
+
+	for (i = 0; i < NKEYWORDS; i++)
+	{
+		int		h;
+
+		if (!is_single_word(&keywords[i]))
+			continue;
+
+		h = hash(&keywords[i]);
+		if (table[h] != -1)
+			return false;
+
+		table[h] = i;
+	}
+
+	return true;
+}
+
+int
+main(void)
+{
+	int		attempt;
+	int		minlen = 0;
+	int		maxlen = 0;
+	int		i;
+
+	for (i = 0; i < NKEYWORDS; i++)
+	{
+		if (!is_single_word(&keywords[i]))
+			continue;
+
+		if (keywords[i].len < 2)
+		{
+			fprintf(stderr, "keyword \"%s\" is too short\n", keywords[i].name);
+			exit(1);
+		}
+
+		if (minlen == 0 || keywords[i].len < minlen)
+			minlen = keywords[i].len;
+		if (keywords[i].len > maxlen)
+			maxlen = keywords[i].len;
+	}
+
+	/* deterministic output */
+	srand(1);
+
+	for (attempt = 0; attempt < MAX_ATTEMPTS; attempt++)
+	{
+		for (i = 0; i < 32; i++)
+			asso[i] = rand() % HASH_SIZE;
+
+		if (try_weights())
+			break;
+	}
+
+	if (attempt == MAX_ATTEMPTS)
+	{
+		fprintf(stderr, "cannot find perfect hash for keywords\n");
+		exit(1);
+	}
+
+	printf("/*\n * Generated by gen_keywords from kwlist.h, don't edit\n */\n\n");
+
+	printf("#define KEYWORD_HASH_SIZE\t%d\n", HASH_SIZE);
+	printf("#define KEYWORD_MIN_LEN\t\t%d\n", minlen);
+	printf("#define KEYWORD_MAX_LEN\t\t%d\n\n", maxlen);
+
+	printf("static const unsigned char keyword_hash_asso[32] = {");
+	for (i = 0; i < 32; i++)
+		printf("%s%s%d", i > 0 ? "," : "", i % 16 == 0 ? "\n\t" : " ", asso[i]);
+	printf("\n};\n\n");
+
+	printf("/* index to keywords table, -1 for empty slot */\n");
+	printf("static const signed char keyword_hash_table[KEYWORD_HASH_SIZE] = {");
+	for (i = 0; i < HASH_SIZE; i++)
+		printf("%s%s%d", i > 0 ? "," : "", i % 16 == 0 ? "\n\t" : " ", table[i]);
+	printf("\n};\n");
+
+	return 0;
+}
@@ -0,0 +1,72 @@
+/*
+ * List of keywords
+ *
+ * Every line is PS_KEYWORD(name, value, reserved). The order of lines
+ * should be same as the order of KeywordValue enum in pspretty.h (it
+ * is checked in compile time). The order is not important for searching,
+ * keywords are searched by perfect hash generated by gen_keywords
+ * into kwlist_d.h. Names with more words are used by multiverb tokens,
+ * and they are not searched.
+ *
+ * There is not any include guard, this file can be included more times
+ * with different definitions of PS_KEYWORD macro.
+ */
+
+PS_KEYWORD("and", k_AND, true)
+PS_KEYWORD("array", k_ARRAY, true)
+PS_KEYWORD("as", k_AS, false)
+PS_KEYWORD("asc", k_ASC, true)
+PS_KEYWORD("between", k_BETWEEN, false)
+PS_KEYWORD("by", k_BY, false)
+PS_KEYWORD("cross", k_CROSS, false)
+PS_KEYWORD("cross join", k_CROSS_JOIN, true)
+PS_KEYWORD("delete", k_DELETE, false)
+PS_KEYWORD("desc", k_DESC, true)
+PS_KEYWORD("exists", k_EXISTS, false)
+PS_KEYWORD("false", k_FALSE, true)
+PS_KEYWORD("first", k_FIRST, false)
+PS_KEYWORD("from", k_FROM, true)
+PS_KEYWORD("full", k_FULL, false)
+PS_KEYWORD("full outer join", k_FULL_OUTER_JOIN, true)
+PS_KEYWORD("group", k_GROUP, false)
+PS_KEYWORD("group by", k_GROUP_BY, true)
+PS_KEYWORD("having", k_HAVING, true)
+PS_KEYWORD("ilike", k_ILIKE, false)
+PS_KEYWORD("in", k_IN, true)
+PS_KEYWORD("inner", k_INNER, false)
+PS_KEYWORD("inner join", k_INNER_JOIN, true)
+PS_KEYWORD("insert", k_INSERT, false)
+PS_KEYWORD("into", k_INTO, true)
+PS_KEYWORD("is", k_IS, true)
+PS_KEYWORD("is not", k_IS_NOT, true)
+PS_KEYWORD("is not null", k_IS_NOT_NULL, true)
+PS_KEYWORD("is null", k_IS_NULL, true)
+PS_KEYWORD("join", k_JOIN, false)
+PS_KEYWORD("last", k_LAST, false)
+PS_KEYWORD("left", k_LEFT, false)
+PS_KEYWORD("left outer join", k_LEFT_OUTER_JOIN, true)
+PS_KEYWORD("like", k_LIKE, false)
+PS_KEYWORD("limit", k_LIMIT, true)
+PS_KEYWORD("natural", k_NATURAL, false)
+PS_KEYWORD("not", k_NOT, true)
+PS_KEYWORD("not in", k_NOT_IN, true)
+PS_KEYWORD("null", k_NULL, true)
+PS_KEYWORD("nulls", k_NULLS, false)
+PS_KEYWORD("nulls first", k_NULLS_FIRST, true)
+PS_KEYWORD("nulls last", k_NULLS_LAST, true)
+PS_KEYWORD("offset", k_OFFSET, true)
+PS_KEYWORD("on", k_ON, false)
+PS_KEYWORD("or", k_OR, true)
+PS_KEYWORD("order", k_ORDER, false)
+PS_KEYWORD("order by", k_ORDER_BY, true)
+PS_KEYWORD("outer", k_OUTER, false)
+PS_KEYWORD("outer join", k_OUTER_JOIN, true)
+PS_KEYWORD("right", k_RIGHT, false)
+PS_KEYWORD("right outer join", k_RIGHT_OUTER_JOIN, true)
+PS_KEYWORD("select", k_SELECT, true)
+PS_KEYWORD("true", k_TRUE, true)
+PS_KEYWORD("unknown", k_UNKNOWN, false)
+PS_KEYWORD("using", k_USING, false)
+PS_KEYWORD("values", k_VALUES, false)
+PS_KEYWORD("where", k_WHERE, true)
+PS_KEYWORD("with", k_WITH, false)
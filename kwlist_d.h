@@ -0,0 +1,24 @@
+/*
+ * Generated by gen_keywords from kwlist.h, don't edit
+ */
+
+#define KEYWORD_HASH_SIZE	128
+#define KEYWORD_MIN_LEN		2
+#define KEYWORD_MAX_LEN		7
+
+static const unsigned char keyword_hash_asso[32] = {
+	20, 97, 72, 82, 11, 60, 53, 98, 104, 26, 2, 45, 72, 119, 75, 49,
+	119, 123, 7, 117, 110, 74, 118, 26, 2, 93, 89, 30, 10, 88, 94, 30
+};
+
+/* index to keywords table, -1 for empty slot */
+static const signed char keyword_hash_table[KEYWORD_HASH_SIZE] = {
+	-1, -1, 29, -1, 5, -1, 25, 47, -1, 8, -1, -1, -1, -1, -1, 39,
+	-1, -1, -1, -1, 49, -1, -1, -1, -1, -1, 24, 30, -1, 9, -1, -1,
+	57, -1, 33, 19, -1, 51, 54, -1, -1, -1, -1, 3, -1, -1, -1, -1,
+	-1, 18, 20, -1, -1, 52, -1, 13, -1, 10, 0, -1, -1, -1, -1, -1,
+	-1, 44, 12, 56, 45, -1, -1, -1, -1, 43, 1, 14, -1, 2, -1, -1,
+	-1, -1, 55, 6, -1, 34, 4, 11, -1, 23, 42, -1, -1, -1, -1, -1,
+	-1, 38, -1, -1, -1, 16, -1, 53, -1, -1, -1, -1, -1, 36, -1, -1,
+	-1, 21, -1, -1, -1, -1, 31, -1, -1, -1, -1, 35, -1, -1, -1, -1
+};
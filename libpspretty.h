@@ -0,0 +1,98 @@
+#ifndef LIBPSPRETTY_H
+
+#define LIBPSPRETTY_H
+
+/*
+ * Public API of libpspretty. The context is opaque, and all errors
+ * are reported by error codes (the library never calls exit). The
+ * context can be used only by one thread at a time, but more contexts
+ * can be used concurrently.
+ *
+ *   PsContext  *ctx = pspretty_create();
+ *
+ *   if (pspretty_parse(ctx, sql, strlen(sql)) == PS_OK &&
+ *       pspretty_format(ctx, buffer, sizeof(buffer), &len) == PS_OK)
+ *       fwrite(buffer, 1, len, stdout);
+ *   else
+ *       fprintf(stderr, "%s\n", pspretty_errmsg(ctx));
+ *
+ *   pspretty_free(ctx);
+ */
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define PS_API		__attribute__((visibility("default")))
+#else
+#define PS_API
+#endif
+
+typedef enum
+{
+	PS_OK = 0,
+	PS_ERROR_SYNTAX,				/* statement cannot be parsed */
+	PS_ERROR_LEXER,					/* unclosed string, identifier or comment */
+	PS_ERROR_INPUT_TOO_LONG,		/* input is longer than 4GB */
+	PS_ERROR_OUT_OF_MEMORY,
+	PS_ERROR_BUFFER_TOO_SMALL,		/* formatted statement doesn't fit to buffer */
+	PS_ERROR_NO_STATEMENT,			/* nothing was parsed */
+	PS_ERROR_INTERNAL,
+	PS_ERROR_TOO_DEEP,				/* statement is nested deeper than max depth */
+	PS_ERROR_TOO_MANY_NODES,		/* statement needs more nodes than max nodes */
+	PS_ERROR_TOO_MANY_TOKENS,		/* statement has more tokens than max tokens */
+	PS_ERROR_TIMEOUT				/* parsing of statement takes longer than timeout */
+} PsErrorCode;
+
+typedef struct PsContext PsContext;
+
+/* returns NULL, when there is not enough memory */
+extern PS_API PsContext *pspretty_create(void);
+extern PS_API void pspretty_free(PsContext *ctx);
+
+/* format options, the defaults are upper case keywords, indent 4 and width 80 */
+extern PS_API void pspretty_set_lower_keywords(PsContext *ctx, bool lower);
+extern PS_API void pspretty_set_indent_width(PsContext *ctx, int width);
+extern PS_API void pspretty_set_line_width(PsContext *ctx, int width);
+
+/*
+ * Limit of nesting of parsed statement, deeper statement fails with
+ * PS_ERROR_TOO_DEEP. The default is safe for 1MB stack.
+ */
+extern PS_API void pspretty_set_max_depth(PsContext *ctx, int depth);
+
+/*
+ * Budgets of parsed statement, zero (default) is unlimited. When the
+ * statement needs more nodes or tokens, or its lexing and parsing
+ * takes longer than timeout (in milliseconds), the parsing is canceled
+ * and the related error code is returned.
+ */
+extern PS_API void pspretty_set_max_nodes(PsContext *ctx, long long nodes);
+extern PS_API void pspretty_set_max_tokens(PsContext *ctx, long long tokens);
+extern PS_API void pspretty_set_timeout(PsContext *ctx, int msec);
+
+/*
+ * Blocks of nodes are allocated by mmap instead of malloc, optionally
+ * on huge pages (with fallback to default pages, when huge pages are
+ * not available). Huge pages can be used only with mmap.
+ */
+extern PS_API void pspretty_set_mmap_nodes(PsContext *ctx, bool mmap_nodes, bool huge_pages);
+
+/*
+ * Parses one statement. The parsed statement holds pointers to str,
+ * so str should not be changed or released before formatting.
+ */
+extern PS_API PsErrorCode pspretty_parse(PsContext *ctx, const char *str, size_t len);
+
+/*
+ * Writes formatted statement to buffer (without terminating zero).
+ * When buffer is too small, PS_ERROR_BUFFER_TOO_SMALL is returned,
+ * and required size is in len.
+ */
+extern PS_API PsErrorCode pspretty_format(PsContext *ctx, char *buffer, size_t size, size_t *len);
+
+/* returns code and message of last error */
+extern PS_API PsErrorCode pspretty_errcode(PsContext *ctx);
+extern PS_API const char *pspretty_errmsg(PsContext *ctx);
+
+#endif
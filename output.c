@@ -0,0 +1,272 @@
+#include <errno.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "pspretty.h"
+
+/*
+ * Output sinks. All printers write to PsOutput, that can hold all
+ * output in memory, or write it to file descriptor or pass it to
+ * callback in large chunks. So the output of large tree needs only
+ * few system calls.
+ */
+#define OUTPUT_BUFFER_SIZE		(64 * 1024)
+
+static void
+output_init(PsOutput *out, PsOutputType type)
+{
+	memset(out, 0, sizeof(PsOutput));
+
+	out->type = type;
+	out->fd = -1;
+	out->size = OUTPUT_BUFFER_SIZE;
+	out->data = malloc(out->size);
+	if (!out->data)
+		out_of_memory();
+}
+
+/*
+ * All output is held in memory, the content is in out->data
+ */
+void
+init_output_buffer(PsOutput *out)
+{
+	output_init(out, po_buffer);
+}
+
+/*
+ * Output is written to file descriptor, when buffer is full
+ * or when output_flush is called.
+ */
+void
+init_output_fd(PsOutput *out, int fd)
+{
+	output_init(out, po_fd);
+	out->fd = fd;
+}
+
+/*
+ * Output is passed to callback, when buffer is full or when
+ * output_flush is called.
+ */
+void
+init_output_callback(PsOutput *out, PsOutputCallback callback, void *arg)
+{
+	output_init(out, po_callback);
+	out->callback = callback;
+	out->callback_arg = arg;
+}
+
+/*
+ * Writes all iovecs to fd. The write can be partial, so the
+ * iovecs are moved after written data.
+ */
+static void
+write_iov(PsOutput *out, struct iovec *iov, int iovcnt)
+{
+	while (iovcnt > 0)
+	{
+		ssize_t		written = writev(out->fd, iov, iovcnt);
+
+		if (written < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			/* the error is reported only once */
+			if (!out->error)
+				fprintf(stderr, "cannot write output: %s\n", strerror(errno));
+
+			out->error = true;
+			return;
+		}
+
+		while (iovcnt > 0 && (size_t) written >= iov->iov_len)
+		{
+			written -= iov->iov_len;
+			iov++;
+			iovcnt--;
+		}
+
+		if (iovcnt > 0)
+		{
+			iov->iov_base = (char *) iov->iov_base + written;
+			iov->iov_len -= written;
+		}
+	}
+}
+
+/*
+ * Writes content of buffer (and optionally data, that doesn't fit
+ * to buffer) to target of output.
+ */
+static void
+output_flush_data(PsOutput *out, const char *str, size_t len)
+{
+	if (out->type == po_fd)
+	{
+		struct iovec iov[2];
+		int		iovcnt = 0;
+
+		if (out->used > 0)
+		{
+			iov[iovcnt].iov_base = out->data;
+			iov[iovcnt++].iov_len = out->used;
+		}
+
+		if (len > 0)
+		{
+			iov[iovcnt].iov_base = (char *) str;
+			iov[iovcnt++].iov_len = len;
+		}
+
+		write_iov(out, iov, iovcnt);
+	}
+	else if (out->type == po_callback)
+	{
+		if (out->used > 0)
+			out->callback(out->data, out->used, out->callback_arg);
+		if (len > 0)
+			out->callback(str, len, out->callback_arg);
+	}
+
+	out->used = 0;
+}
+
+/*
+ * Ensure free space for len bytes in buffer
+ */
+static void
+output_reserve(PsOutput *out, size_t len)
+{
+	char   *data;
+	size_t	size;
+
+	if (out->used + len <= out->size)
+		return;
+
+	if (out->type != po_buffer)
+	{
+		output_flush_data(out, NULL, 0);
+
+		if (len <= out->size)
+			return;
+	}
+
+	size = out->size;
+	while (out->used + len > size)
+		size *= 2;
+
+	/* the buffer should be valid, when out_of_memory doesn't exit */
+	data = realloc(out->data, size);
+	if (!data)
+		out_of_memory();
+
+	out->data = data;
+	out->size = size;
+}
+
+void
+output_write(PsOutput *out, const char *str, size_t len)
+{
+	if (out->used + len <= out->size)
+	{
+		memcpy(out->data + out->used, str, len);
+		out->used += len;
+	}
+	else if (out->type != po_buffer && len >= out->size / 2)
+	{
+		/* large data are not copied to buffer */
+		output_flush_data(out, str, len);
+	}
+	else
+	{
+		output_reserve(out, len);
+
+		memcpy(out->data + out->used, str, len);
+		out->used += len;
+	}
+}
+
+void
+output_str(PsOutput *out, const char *str)
+{
+	output_write(out, str, strlen(str));
+}
+
+void
+output_char(PsOutput *out, char c)
+{
+	if (out->used == out->size)
+		output_reserve(out, 1);
+
+	out->data[out->used++] = c;
+}
+
+/*
+ * Writes n spaces
+ */
+void
+output_indent(PsOutput *out, int n)
+{
+	if (n <= 0)
+		return;
+
+	output_reserve(out, n);
+
+	memset(out->data + out->used, ' ', n);
+	out->used += n;
+}
+
+void
+output_printf(PsOutput *out, const char *fmt, ...)
+{
+	va_list		args;
+	int			len;
+
+	va_start(args, fmt);
+	len = vsnprintf(out->data + out->used, out->size - out->used, fmt, args);
+	va_end(args);
+
+	if (len < 0)
+		return;
+
+	/* there was not enough space, try again */
+	if ((size_t) len >= out->size - out->used)
+	{
+		output_reserve(out, len + 1);
+
+		va_start(args, fmt);
+		len = vsnprintf(out->data + out->used, out->size - out->used, fmt, args);
+		va_end(args);
+	}
+
+	out->used += len;
+}
+
+/*
+ * Writes buffered data. For memory buffer it does nothing.
+ */
+void
+output_flush(PsOutput *out)
+{
+	if (out->type != po_buffer)
+		output_flush_data(out, NULL, 0);
+}
+
+/*
+ * Flushes buffered data and frees the buffer
+ */
+void
+free_output(PsOutput *out)
+{
+	output_flush(out);
+
+	free(out->data);
+
+	memset(out, 0, sizeof(PsOutput));
+}
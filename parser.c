@@ -1,34 +1,41 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 #include "pspretty.h"
 
-static Node * is_expr_in_parenthesis(bool *error);
-static Node * is_function_args(bool *error);
-static Node * is_query(bool *error);
-static Node * is_expr_list(bool *error);
+static Node * is_expr_in_parenthesis(PsParser *ps, bool *error);
+static Node * is_function_args(PsParser *ps, bool *error);
+static Node * is_query(PsParser *ps, bool *error);
+static Node * is_expr_list(PsParser *ps, bool *error);
+static Node * is_array_constructor(PsParser *ps, bool *error, Token *keyword);
 
 static bool is_join_keyword(Token *t);
-static Node * is_relation_expr(bool *error, bool join_required, Node *leftrel);
-static Node * is_relation_expr_list(bool *error);
+static Node * is_relation_expr(PsParser *ps, bool *error, bool join_required, Node *leftrel);
+static Node * is_relation_expr_list(PsParser *ps, bool *error);
 
-static Node * is_operand(bool *error);
-static Node * new_node(NodeType type);
+static Node * is_operand(PsParser *ps, bool *error);
+static Node * new_node(PsParser *ps, NodeType type);
+static void * new_node_memory(PsParser *ps, size_t bytes);
+
+static Node * _is_operand(PsParser *ps, bool *error);
+static Node * _is_expr_prec(PsParser *ps, bool *error, int min_prec,
+							Token **lookahead, Token *buffer);
+static Node * _is_relation_expr(PsParser *ps, bool *error, bool join_required, Node *leftrel);
+static Node * _is_query(PsParser *ps, bool *error);
 
 
 #define	ON_ERROR_RETURN()			do { if (*error) { return NULL;} } while (0)
 #define	ON_EMPTY_RETURN_ERROR()		do { if (!_t) { *error = 1; return NULL; }} while (0)
 #define	RETURN_ERROR()				do { *error = 1; return NULL; } while (0)
 
-NodeAllocator	   *root_allocator;
-NodeAllocator	   *current_allocator;
-
 
 static Node *
-new_node_value(NodeType type, Node *value)
+new_node_value(PsParser *ps, NodeType type, Node *value)
 {
-	Node *result = new_node(type);
+	Node *result = new_node(ps, type);
 
 	result->value = value;
 	if (type == n_expr)
@@ -38,11 +45,11 @@ new_node_value(NodeType type, Node *value)
 }
 
 static Node *
-new_node_str(NodeType type, Token *token)
+new_node_str(PsParser *ps, NodeType type, Token *token)
 {
-	Node *result = new_node(type);
+	Node *result = new_node(ps, type);
 
-	result->str = token->str;
+	result->str = TOKEN_STR(ps, token);
 	result->bytes = token->bytes;
 
 	if (type == n_expr)
@@ -51,10 +58,93 @@ new_node_str(NodeType type, Token *token)
 	return result;
 }
 
+/*
+ * All recursion of parser goes through is_operand, is_expr_prec,
+ * is_relation_expr and is_query. These functions are wrappers, that
+ * count current depth of recursion. When the depth is higher than
+ * max_depth, then the parsing fails, so the stack cannot overflow.
+ */
+static inline bool
+increase_depth(PsParser *ps, bool *error)
+{
+	if (ps->depth >= ps->max_depth)
+	{
+		parser_error(ps, PS_ERROR_TOO_DEEP,
+					 "statement is nested too deeply (max depth is %d)",
+					 ps->max_depth);
+		*error = true;
+		return false;
+	}
+
+	ps->depth += 1;
+
+	if (ps->stats && ps->depth > ps->stats->max_depth)
+		ps->stats->max_depth = ps->depth;
+
+	return true;
+}
+
+static Node *
+is_operand(PsParser *ps, bool *error)
+{
+	Node   *result;
+
+	if (!increase_depth(ps, error))
+		return NULL;
+
+	result = _is_operand(ps, error);
+	ps->depth -= 1;
+
+	return result;
+}
+
+static Node *
+is_expr_prec(PsParser *ps, bool *error, int min_prec,
+			 Token **lookahead, Token *buffer)
+{
+	Node   *result;
+
+	if (!increase_depth(ps, error))
+		return NULL;
+
+	result = _is_expr_prec(ps, error, min_prec, lookahead, buffer);
+	ps->depth -= 1;
+
+	return result;
+}
+
+static Node *
+is_relation_expr(PsParser *ps, bool *error, bool join_required, Node *leftrel)
+{
+	Node   *result;
+
+	if (!increase_depth(ps, error))
+		return NULL;
+
+	result = _is_relation_expr(ps, error, join_required, leftrel);
+	ps->depth -= 1;
+
+	return result;
+}
+
+static Node *
+is_query(PsParser *ps, bool *error)
+{
+	Node   *result;
+
+	if (!increase_depth(ps, error))
+		return NULL;
+
+	result = _is_query(ps, error);
+	ps->depth -= 1;
+
+	return result;
+}
+
 static bool
 is_keyword(Token *token, KeywordValue k)
 {
-	return token->type == tt_keyword && token->value == k;
+	return token->type == tt_keyword && token->value == (int) k;
 }
 
 static bool
@@ -70,11 +160,11 @@ is_enhanced_ident(Token *token)
 }
 
 static bool
-is_operator(Token *token, const char *op)
+is_operator(PsParser *ps, Token *token, const char *op)
 {
 	if (token->type == tt_operator &&
 			token->bytes == strlen(op) &&
-			strncmp(token->str, op, token->bytes) == 0)
+			strncmp(TOKEN_STR(ps, token), op, token->bytes) == 0)
 		return true;
 	return false;
 }
@@ -84,32 +174,31 @@ is_operator(Token *token, const char *op)
  *
  */
 static Node *
-is_qualified_ident(bool *error)
+is_qualified_ident(PsParser *ps, bool *error)
 {
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
 	if (is_enhanced_ident(_t))
 	{
 		Token	t2, *_t2;
-		Node	*_node;
 		bool	revert = false;
 
-		_t2 = next_token(&t2);
+		_t2 = next_token(ps, &t2);
 		ON_EMPTY_RETURN_ERROR();
 
-		if (t2.type == tt_dot)
+		if (_t2->type == tt_dot)
 		{
 			Node   *other;
 
-			other = is_qualified_ident(error);
+			other = is_qualified_ident(ps, error);
 			ON_ERROR_RETURN();
 			if (other)
 			{
 				/* allocation is done in last moment, because there is not free */
-				Node   *result = new_node_str(n_ident, _t);
+				Node   *result = new_node_str(ps, n_ident, _t);
 
 				result->other = other;
 				return result;
@@ -118,12 +207,12 @@ is_qualified_ident(bool *error)
 				revert = true;
 		}
 
-		push_token(_t2);
+		push_token(ps, _t2);
 		if (!revert)
-			return new_node_str(n_ident, _t);
+			return new_node_str(ps, n_ident, _t);
 	}
 
-	push_token(_t);
+	push_token(ps, _t);
 	return NULL;
 }
 
@@ -132,30 +221,30 @@ is_qualified_ident(bool *error)
  *
  */
 static Node *
-is_qualified_star(bool *error)
+is_qualified_star(PsParser *ps, bool *error)
 {
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
-	if (is_operator(_t, "*"))
+	if (is_operator(ps, _t, "*"))
 	{
-		return new_node_str(n_star, _t);
+		return new_node_str(ps, n_star, _t);
 	}
 	else if (is_enhanced_ident(_t))
 	{
 		Token	t2, *_t2;
 
-		_t2 = next_token(&t2);
+		_t2 = next_token(ps, &t2);
 		ON_EMPTY_RETURN_ERROR();
 
-		if (t2.type == tt_dot)
+		if (_t2->type == tt_dot)
 		{
 			Node   *result;
 
-			result = new_node_str(n_star, _t);
-			if(result->other = is_qualified_star(error))
+			result = new_node_str(ps, n_star, _t);
+			if ((result->other = is_qualified_star(ps, error)))
 			{
 				return result;
 			}
@@ -163,641 +252,878 @@ is_qualified_star(bool *error)
 			ON_ERROR_RETURN();
 		}
 
-		push_token(_t2);
+		push_token(ps, _t2);
 	}
 
-	push_token(_t);
+	push_token(ps, _t);
 	return NULL;
 }
 
 
+/*
+ * Operand can be:
+ *
+ *   [+|-] operand, ( expr ), (SELECT ...), ( expr, expr, ...),
+ *   qualified ident, function call, literal
+ *
+ * The first token is read only once, and decides about the branch.
+ */
 static Node *
-is_signed_operand(bool *error)
+_is_operand(PsParser *ps, bool *error)
 {
 	Token	t, *_t;
+	Node   *result;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
-	if (is_operator(_t, "+") || is_operator(_t, "-"))
+	if (is_operator(ps, _t, "+") || is_operator(ps, _t, "-"))
 	{
-		Node	*result;
-
-		result = is_operand(error);
+		result = is_operand(ps, error);
 		ON_ERROR_RETURN();
 
 		if (result)
 		{
-			if (strncmp(t.str, "-", 1) == 0)
+			if (*TOKEN_STR(ps, _t) == '-')
 			{
 				if (result->type != n_expr && result->type != n_expr_wrapper)
-					result = new_node_value(n_expr_wrapper, result);
+					result = new_node_value(ps, n_expr_wrapper, result);
 
 				result->negative = !result->negative;
 			}
 			return result;
 		}
 	}
+	else if (_t->type == tt_lparent)
+	{
+		push_token(ps, _t);
+		return is_expr_in_parenthesis(ps, error);
+	}
+	else if (is_keyword(_t, k_ARRAY))
+		return is_array_constructor(ps, error, _t);
+	else if (is_enhanced_ident(_t))
+	{
+		push_token(ps, _t);
+
+		if ((result = is_qualified_ident(ps, error)))
+		{
+			Node   *fx;
+
+			fx = is_function_args(ps, error);
+			ON_ERROR_RETURN();
+			if (fx)
+			{
+				/* name is in other field */
+				fx->other = result;
+				return fx;
+			}
+
+			return result;
+		}
+		ON_ERROR_RETURN();
+
+		return NULL;
+	}
+	else if (is_keyword(_t, k_NULL))
+		return new_node_str(ps, n_null, _t);
+	else if (is_keyword(_t, k_FALSE))
+		return new_node_str(ps, n_false, _t);
+	else if (is_keyword(_t, k_TRUE))
+		return new_node_str(ps, n_true, _t);
+	else if (_t->type == tt_numeric)
+		return new_node_str(ps, n_numeric, _t);
+	else if (_t->type == tt_string)
+		return new_node_str(ps, n_string, _t);
 
-	push_token(_t);
+	push_token(ps, _t);
 	return NULL;
 }
 
 /*
- * NOT operand
+ * Precedence of expression operators, higher value binds stronger.
  *
+ * The chain of OR or AND is one node with all operands, generic
+ * operators are right associative, other operators are not
+ * associative (a = b = c is not allowed).
  */
-static Node *
-is_negated_operand(bool *error)
-{
-	Token	t, *_t;
-
-	_t = next_token(&t);
-	ON_EMPTY_RETURN_ERROR();
+#define PREC_NONE		0
+#define PREC_OR			1		/* expr OR expr */
+#define PREC_AND		2		/* expr AND expr */
+#define PREC_NOT		3		/* NOT expr */
+#define PREC_EQ			4		/* expr = expr */
+#define PREC_CMP		5		/* expr <> expr, <, >, <=, >= */
+#define PREC_LIKE		6		/* expr LIKE expr, expr ILIKE expr, expr IN (...) */
+#define PREC_BETWEEN	7		/* expr BETWEEN expr AND expr */
+#define PREC_IS_NULL	8		/* expr IS NULL, expr IS NOT NULL */
+#define PREC_IS			9		/* expr IS [NOT] TRUE | FALSE | UNKNOWN */
+#define PREC_OP			10		/* expr op expr */
+#define PREC_MAX		11
 
-	if (is_keyword(_t, k_NOT))
+/*
+ * Returns precedence of binary or postfix operator, or PREC_NONE,
+ * when the token cannot continue an expression.
+ */
+static int
+operator_precedence(PsParser *ps, Token *token)
+{
+	if (token->type == tt_operator)
 	{
-		Node	*result;
-
-		result = is_operand(error);
-		ON_ERROR_RETURN();
+		if (!token->comparing_op)
+			return PREC_OP;
 
-		if (result)
+		return is_operator(ps, token, "=") ? PREC_EQ : PREC_CMP;
+	}
+	else if (token->type == tt_keyword)
+	{
+		switch (token->value)
 		{
-			if (result->type != n_expr && result->type != n_expr_wrapper)
-				result = new_node_value(n_expr_wrapper, result);
-
-			result->negate = true;
-			return result;
+			case k_OR:
+				return PREC_OR;
+			case k_AND:
+				return PREC_AND;
+			case k_LIKE:
+			case k_ILIKE:
+			case k_IN:
+			case k_NOT_IN:
+				return PREC_LIKE;
+			case k_BETWEEN:
+				return PREC_BETWEEN;
+			case k_IS_NULL:
+			case k_IS_NOT_NULL:
+				return PREC_IS_NULL;
+			case k_IS:
+				return PREC_IS;
+			default:
+				;
 		}
 	}
 
-	push_token(_t);
-	return NULL;
+	return PREC_NONE;
 }
 
-static Node *
-is_operand(bool *error)
+/*
+ * Pushes operand of AND, OR chain to stack of operands
+ */
+static void
+push_operand(PsParser *ps, Node *node)
 {
-	Token	t, *_t;
-	Node   *result;
-
-	if (result = is_signed_operand(error))
-		return result;
-	ON_ERROR_RETURN();
-
-	if (result = is_expr_in_parenthesis(error))
-		return result;
-	ON_ERROR_RETURN();
-
-	if (result = is_qualified_ident(error))
+	if (ps->noperands >= ps->operands_size)
 	{
-		Node   *fx;
+		int		size = ps->operands_size > 0 ? ps->operands_size * 2 : 64;
+		Node  **operands;
 
-		fx = is_function_args(error);
-		ON_ERROR_RETURN();
-		if (fx)
-		{
-			/* name is in other field */
-			fx->other = result;
-			return fx;
-		}
+		/* the stack should be valid, when out_of_memory doesn't exit */
+		operands = realloc(ps->operands, size * sizeof(Node *));
+		if (!operands)
+			out_of_memory();
 
-		return result;
+		ps->operands = operands;
+		ps->operands_size = size;
 	}
 
-	_t = next_token(&t);
-	ON_EMPTY_RETURN_ERROR();
+	ps->operands[ps->noperands++] = node;
+}
 
-	if (is_keyword(_t, k_NULL))
-		return new_node_str(n_null, _t);
-	else if (is_keyword(_t, k_FALSE))
-		return new_node_str(n_false, _t);
-	else if (is_keyword(_t, k_TRUE))
-		return new_node_str(n_true, _t);
-	else if (t.type == tt_numeric)
-		return new_node_str(n_numeric, _t);
-	else if (t.type == tt_string)
-		return new_node_str(n_string, _t);
-	else if (is_not_reserved_keyword(_t))
-		return new_node_str(n_string, _t);
-
-	push_token(_t);
-	return NULL;
+static bool
+is_exists_expr(Node *node)
+{
+	return node->type == n_expr && !node->other && !node->parenthesis &&
+		node->value && node->value->type == n_query;
 }
 
 /*
- * Operand | Operand op expr
- *
+ * Applies operators with precedence from min_prec to max_prec (without
+ * max_prec) to parsed operand. The lookahead holds the first token
+ * after operand.
  */
 static Node *
-is_expr_00(bool *error)
+expr_operators(PsParser *ps, bool *error, Node *result,
+			   int min_prec, int max_prec,
+			   Token **lookahead, Token *buffer)
 {
 	Token	t, *_t;
-	Node   *result;
-
-	_t = next_token(&t);
-	ON_EMPTY_RETURN_ERROR();
 
-	if (is_keyword(_t, k_EXISTS))
+	for (;;)
 	{
-		Token	t2, *_t2;
+		int		prec = operator_precedence(ps, *lookahead);
+		Node   *expr;
 
-		_t2 = next_token(&t2);
-		ON_EMPTY_RETURN_ERROR();
+		if (prec == PREC_NONE || prec < min_prec || prec >= max_prec)
+			break;
 
-		if (t2.type == tt_lparent)
+		if (prec == PREC_IS)
 		{
-			Node	*query;
-			push_token(_t2);
+			bool	is_not = false;
 
-			query = is_expr_in_parenthesis(error);
-			ON_ERROR_RETURN();
+			_t = next_token(ps, &t);
+			ON_EMPTY_RETURN_ERROR();
 
-			if (query->type == n_query)
+			if (is_keyword(_t, k_NOT))
 			{
-				result = new_node_str(n_expr, _t);
-				result->value = query;
-
-				return result;
+				is_not = true;
+				_t = next_token(ps, &t);
+				ON_EMPTY_RETURN_ERROR();
 			}
 
-			RETURN_ERROR();
-		}
+			if (!(is_keyword(_t, k_UNKNOWN) ||
+				  is_keyword(_t, k_FALSE) || is_keyword(_t, k_TRUE)))
+				RETURN_ERROR();
 
-		push_token(_t2);
-	}
+			expr = new_node_str(ps, n_is, _t);
+			expr->value = result;
+			expr->is_not = is_not;
 
-	push_token(_t);
+			_t = *lookahead = next_token(ps, buffer);
+			ON_EMPTY_RETURN_ERROR();
+		}
+		else if (prec == PREC_IS_NULL)
+		{
+			expr = new_node_str(ps,
+								is_keyword(*lookahead, k_IS_NULL) ? n_is_null : n_is_not_null,
+								*lookahead);
+			expr->value = result;
 
-	if (result = is_operand(error))
-	{
-		Token	t, *_t;
+			_t = *lookahead = next_token(ps, buffer);
+			ON_EMPTY_RETURN_ERROR();
+		}
+		else if (is_keyword(*lookahead, k_IN) || is_keyword(*lookahead, k_NOT_IN))
+		{
+			expr = new_node_str(ps, n_expr, *lookahead);
+			expr->exprtype = is_keyword(*lookahead, k_IN) ? expr_in : expr_not_in;
+			expr->value = result;
 
-		ON_ERROR_RETURN();
+			/* list of values or subquery */
+			expr->other = is_expr_in_parenthesis(ps, error);
+			ON_ERROR_RETURN();
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
+			if (!expr->other)
+				RETURN_ERROR();
 
-		if (t.type == tt_operator && !t.comparing_op)
+			_t = *lookahead = next_token(ps, buffer);
+			ON_EMPTY_RETURN_ERROR();
+		}
+		else if (prec == PREC_BETWEEN)
 		{
-			Node   *expr = new_node_str(n_expr, _t);
+			Node   *lval;
 
+			expr = new_node_str(ps, n_expr, *lookahead);
 			expr->value = result;
+			expr->exprtype = expr_between;
 
-			if (expr->other = is_expr_00(error))
-				return expr;
+			lval = is_expr_prec(ps, error, PREC_IS_NULL, lookahead, buffer);
+			ON_ERROR_RETURN();
 
-			RETURN_ERROR();
-		}
+			if (!lval || !is_keyword(*lookahead, k_AND))
+				RETURN_ERROR();
 
-		push_token(_t);
-		return result;
-	}
+			expr->other = new_node_str(ps, n_expr, *lookahead);
+			expr->other->value = lval;
 
-	return NULL;
-}
+			expr->other->other = is_expr_prec(ps, error, PREC_IS_NULL, lookahead, buffer);
+			ON_ERROR_RETURN();
 
-/*
- * Add expr IS FALSE, expr IS TRUE, expr IS UNKNOWN
- */
-static Node *
-is_expr_01(bool *error)
-{
-	Node	*result;
+			if (!expr->other->other)
+				RETURN_ERROR();
+		}
+		else if (prec == PREC_OR || prec == PREC_AND)
+		{
+			KeywordValue op = (*lookahead)->value;
+			int		start = ps->noperands;
 
-	if (result = is_expr_00(error))
-	{
-		Token	t, *_t;
+			expr = new_node_str(ps, prec == PREC_OR ? n_logical_or : n_logical_and,
+								*lookahead);
 
-		ON_ERROR_RETURN();
+			/*
+			 * The chain of same operator is one node with array of operands.
+			 * The operands are collected by loop, so long chain doesn't need
+			 * deep stack. The operands cannot contain this operator, but it
+			 * can be in nested chains in parenthesis, so the operands are
+			 * collected on shared stack.
+			 */
+			push_operand(ps, result);
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
+			do
+			{
+				Node   *operand;
 
-		if (is_keyword(_t, k_IS))
-		{
-			bool	negate = false;
+				operand = is_expr_prec(ps, error, prec + 1, lookahead, buffer);
+				ON_ERROR_RETURN();
 
-			_t = next_token(&t);
-			ON_EMPTY_RETURN_ERROR();
+				if (!operand)
+					RETURN_ERROR();
 
-			if (is_keyword(_t, k_NOT))
-			{
-				negate = true;
-				_t = next_token(&t);
-				ON_EMPTY_RETURN_ERROR();
+				push_operand(ps, operand);
 			}
+			while (is_keyword(*lookahead, op));
 
-			if (is_keyword(_t, k_UNKNOWN) ||
-				is_keyword(_t, k_FALSE) || is_keyword(_t, k_TRUE))
-			{
-				Node   *expr = new_node_str(n_is, _t);
-
-				expr->value = result;
-				expr->negate = negate;
-				return expr;
-			}
+			expr->nargs = ps->noperands - start;
+			expr->args = new_node_memory(ps, expr->nargs * sizeof(Node *));
+			memcpy(expr->args, ps->operands + start, expr->nargs * sizeof(Node *));
 
-			RETURN_ERROR();
+			ps->noperands = start;
 		}
+		else if (prec == PREC_OP)
+		{
+			int		start = ps->noperands;
+			Node   *operand;
+			int		i;
+
+			/*
+			 * Generic operators are right associative, and they have highest
+			 * precedence, so a op b op c is a op (b op c). The chain is parsed
+			 * by loop, and the nodes are linked after, so long chain doesn't
+			 * need deep stack.
+			 */
+			for (;;)
+			{
+				expr = new_node_str(ps, n_expr, *lookahead);
+				expr->value = result;
+				push_operand(ps, expr);
 
-		push_token(_t);
-	}
-
-	return result;
-}
+				operand = is_expr_prec(ps, error, PREC_MAX, lookahead, buffer);
+				ON_ERROR_RETURN();
 
-/*
- * Add expr IS NULL, expr IS NOT NULL
- *
- */
-static Node *
-is_expr_02(bool *error)
-{
-	Node	*result;
+				if (!operand)
+					RETURN_ERROR();
 
-	if (result = is_expr_01(error))
-	{
-		Token	t, *_t;
+				/* EXISTS (subquery) cannot be operand of generic operator */
+				if (is_exists_expr(operand) ||
+					operator_precedence(ps, *lookahead) != PREC_OP)
+					break;
 
-		ON_ERROR_RETURN();
+				result = operand;
+			}
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
+			for (i = ps->noperands - 1; i >= start; i--)
+			{
+				ps->operands[i]->other = operand;
+				operand = ps->operands[i];
+			}
 
-		if (is_keyword(_t, k_IS_NULL) ||
-			is_keyword(_t, k_IS_NOT_NULL))
+			expr = ps->operands[start];
+			ps->noperands = start;
+		}
+		else
 		{
-			Node   *expr = new_node_str(is_keyword(_t, k_IS_NULL) ? n_is_null : n_is_not_null, _t);
+			expr = new_node_str(ps, n_expr, *lookahead);
+			if (prec == PREC_LIKE)
+				expr->exprtype = is_keyword(*lookahead, k_LIKE) ? expr_like : expr_ilike;
 
 			expr->value = result;
-			return expr;
+			expr->other = is_expr_prec(ps, error, prec + 1, lookahead, buffer);
+			ON_ERROR_RETURN();
+
+			if (!expr->other)
+				RETURN_ERROR();
 		}
 
-		push_token(_t);
+		/*
+		 * Operators with same or higher precedence are consumed already
+		 * by right operand, or they cannot follow (not associative operators).
+		 */
+		result = expr;
+		max_prec = prec;
 	}
 
 	return result;
 }
 
 /*
- * expr BETWEEN expr AND expr
+ * Parses expression with operators with precedence min_prec or higher
+ * (precedence climbing). Every token is read only once. The first token
+ * after expression is not pushed back, but it is returned in lookahead
+ * (only when result is not NULL). The buffer is storage for lookahead
+ * token, when token is not in token array.
  */
 static Node *
-is_expr_04(bool *error)
+_is_expr_prec(PsParser *ps, bool *error, int min_prec,
+			  Token **lookahead, Token *buffer)
 {
+	Token	t, *_t;
 	Node   *result;
+	int		max_prec = PREC_MAX;
+	bool	has_lookahead = false;
 
-	if (result = is_expr_02(error))
-	{
-		Token	t, *_t;
+	_t = next_token(ps, &t);
+	ON_EMPTY_RETURN_ERROR();
 
+	if (is_keyword(_t, k_NOT) && min_prec <= PREC_NOT)
+	{
+		result = is_expr_prec(ps, error, PREC_EQ, lookahead, buffer);
 		ON_ERROR_RETURN();
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
-
-		if (is_keyword(_t, k_BETWEEN))
+		if (!result)
 		{
-			Node   *expr = new_node_str(n_expr, _t);
-			Node   *lval;
+			push_token(ps, _t);
+			return NULL;
+		}
 
-			expr->value = result;
-			expr->exprtype = expr_between;
+		result->negate = true;
+		has_lookahead = true;
 
-			lval = is_expr_02(error);
-			ON_ERROR_RETURN();
+		/* only AND or OR can follow */
+		max_prec = PREC_NOT;
+	}
+	else if (is_keyword(_t, k_EXISTS))
+	{
+		Token	t2, *_t2;
 
-			_t = next_token(&t);
-			ON_EMPTY_RETURN_ERROR();
+		_t2 = next_token(ps, &t2);
+		if (!_t2)
+			RETURN_ERROR();
 
-			if (is_keyword(_t, k_AND))
-			{
-				expr->other = new_node_str(n_expr,_t);
-				expr->other->value = lval;
+		push_token(ps, _t2);
 
-				if (expr->other->other = is_expr_02(error))
-					return expr;
-			}
+		if (_t2->type == tt_lparent)
+		{
+			Node	*query;
 
+			query = is_expr_in_parenthesis(ps, error);
 			ON_ERROR_RETURN();
-			RETURN_ERROR();
+
+			/* subquery is wrapped, because it is in parenthesis */
+			if (query && query->type == n_expr_wrapper)
+				query = query->value;
+
+			if (!query || query->type != n_query)
+				RETURN_ERROR();
+
+			result = new_node_str(ps, n_expr, _t);
+			result->value = query;
+
+			/* EXISTS (subquery) cannot be operand of generic operator */
+			max_prec = PREC_OP;
+		}
+		else
+		{
+			push_token(ps, _t);
+			result = is_operand(ps, error);
 		}
+	}
+	else
+	{
+		push_token(ps, _t);
+		result = is_operand(ps, error);
+	}
+
+	ON_ERROR_RETURN();
+	if (!result)
+		return NULL;
 
-		push_token(_t);
+	if (!has_lookahead)
+	{
+		_t = *lookahead = next_token(ps, buffer);
+		ON_EMPTY_RETURN_ERROR();
 	}
 
-	return result;
+	return expr_operators(ps, error, result, min_prec, max_prec,
+						  lookahead, buffer);
 }
 
 /*
- * expr LIKE expr, expr ILIKE expr
+ * Top level of expression
+ *
  */
 static Node *
-is_expr_05(bool *error)
+is_expr_top(PsParser *ps, bool *error)
 {
+	Token	buffer, *lookahead;
 	Node   *result;
 
-	if (result = is_expr_04(error))
-	{
-		Token	t, *_t;
+	result = is_expr_prec(ps, error, PREC_OR, &lookahead, &buffer);
+	ON_ERROR_RETURN();
 
-		ON_ERROR_RETURN();
-
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
-
-		if (is_keyword(_t, k_LIKE) || is_keyword(_t, k_ILIKE))
-		{
-			Node   *expr = new_node_str(n_expr, _t);
-
-			expr->value = result;
-			expr->exprtype = is_keyword(_t, k_LIKE) ? expr_like : expr_ilike;
-
-			if (expr->other = is_expr_04(error))
-				return expr;
-
-			ON_ERROR_RETURN();
-			RETURN_ERROR();
-		}
-
-		push_token(_t);
-	}
+	if (result)
+		push_token(ps, lookahead);
 
 	return result;
 }
 
 /*
- * expr <> expr
+ * Top level of expression, that starts by already parsed operand
+ *
  */
 static Node *
-is_expr_06(bool *error)
+is_expr_top_continue(PsParser *ps, bool *error, Node *operand)
 {
+	Token	buffer, *lookahead;
 	Node   *result;
 
-	if (result = is_expr_05(error))
-	{
-		Token	t, *_t;
-
-		ON_ERROR_RETURN();
+	lookahead = next_token(ps, &buffer);
+	if (!lookahead)
+		RETURN_ERROR();
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
+	result = expr_operators(ps, error, operand, PREC_OR, PREC_MAX,
+							&lookahead, &buffer);
+	ON_ERROR_RETURN();
 
-		if (t.type == tt_operator && t.comparing_op && !is_operator(_t, "="))
-		{
-			Node   *expr = new_node_str(n_expr, _t);
+	push_token(ps, lookahead);
 
-			expr->value = result;
-			if (expr->other = is_expr_05(error))
-				return expr;
+	return result;
+}
 
-			ON_ERROR_RETURN();
-			RETURN_ERROR();
-		}
+/*
+ * Returns true, when next token is comma. Else the token is pushed
+ * back. The lists are parsed by loops (not by recursion), so long
+ * lists doesn't need deep stack.
+ */
+static bool
+is_next_comma(PsParser *ps, bool *error)
+{
+	Token	t, *_t;
 
-		push_token(_t);
+	_t = next_token(ps, &t);
+	if (!_t)
+	{
+		*error = true;
+		return false;
 	}
 
-	return result;
+	if (_t->type == tt_comma)
+		return true;
+
+	push_token(ps, _t);
+	return false;
+}
+
+/*
+ * Returns NodeType of constant, or -1, when token is not constant
+ */
+static int
+literal_type(Token *token)
+{
+	if (token->type == tt_numeric)
+		return n_numeric;
+	else if (token->type == tt_string)
+		return n_string;
+	else if (is_keyword(token, k_NULL))
+		return n_null;
+	else if (is_keyword(token, k_TRUE))
+		return n_true;
+	else if (is_keyword(token, k_FALSE))
+		return n_false;
+
+	return -1;
 }
 
 /*
- * expr = expr
+ * Fast path for lists of constants (IN lists, rows of VALUES, ARRAY[]).
+ * When the tokens to closing token are only constants separated by
+ * commas, then they are stored in one literal array node, without
+ * nodes for items and without expression parser. The tokens should
+ * be checked before they are consumed, so it is possible only, when
+ * they are in token array. Returns NULL (and doesn't consume any
+ * token), when the list is not list of two or more constants. The
+ * closing token is not consumed.
  */
 static Node *
-is_expr_07(bool *error)
+is_literal_array(PsParser *ps, TokenType closing)
 {
+	Token  *tokens;
 	Node   *result;
+	Token  *last;
+	int		n = 0;
+	int		i;
+
+	if (!ps->tokens_ready || ps->tokencur >= ps->ntokens)
+		return NULL;
 
-	if (result = is_expr_06(error))
+	tokens = &ps->tokens[ps->tokencur];
+
+	/* the array is closed by EOF token, so the check stops there */
+	for (i = 0;; i += 2)
 	{
-		Token	t, *_t;
+		if (literal_type(&tokens[i]) < 0)
+			return NULL;
 
-		ON_ERROR_RETURN();
+		n += 1;
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
+		if (tokens[i + 1].type == closing)
+			break;
 
-		if (is_operator(_t, "="))
-		{
-			Node   *expr = new_node_str(n_expr, _t);
+		if (tokens[i + 1].type != tt_comma)
+			return NULL;
+	}
 
-			expr->value = result;
-			if (expr->other = is_expr_06(error))
-				return expr;
+	if (n < 2)
+		return NULL;
 
-			ON_ERROR_RETURN();
-			RETURN_ERROR();
-		}
+	last = &tokens[i];
+
+	result = new_node_str(ps, n_literal_array, &tokens[0]);
+	result->bytes = last->offset + last->bytes - tokens[0].offset;
+
+	result->literals = new_node_memory(ps, n * sizeof(Literal));
+	result->nargs = n;
 
-		push_token(_t);
+	for (i = 0; i < n; i++)
+	{
+		Token  *token = &tokens[i * 2];
+		Literal *literal = &result->literals[i];
+
+		literal->offset = token->offset - tokens[0].offset;
+		literal->bytes = token->bytes;
+		literal->type = literal_type(token);
 	}
 
+	ps->tokencur += n * 2 - 1;
+
 	return result;
 }
 
 /*
- * NOT expr
+ * expr | [ ... ] [, ...]
+ *
+ * returns list of items of array, the nested arrays are in brackets
+ * without ARRAY keyword.
+ *
  */
 static Node *
-is_expr_08(bool *error)
+is_array_item_list(PsParser *ps, bool *error)
 {
-	Token	t, *_t;
-
-	_t = next_token(&t);
-	ON_EMPTY_RETURN_ERROR();
+	Node   *result = NULL;
+	Node  **tail = &result;
 
-	if (is_keyword(_t, k_NOT))
+	do
 	{
-		Node	*result;
+		Token	t, *_t;
+		Node   *item;
+
+		_t = next_token(ps, &t);
+		ON_EMPTY_RETURN_ERROR();
+
+		push_token(ps, _t);
+
+		if (_t->type == tt_lbracket)
+		{
+			/* nested arrays are not parsed by wrappers */
+			if (!increase_depth(ps, error))
+				return NULL;
+
+			item = is_array_constructor(ps, error, NULL);
+			ps->depth -= 1;
+		}
+		else
+			item = is_expr_top(ps, error);
 
-		result = is_expr_07(error);
 		ON_ERROR_RETURN();
 
-		if (result)
+		if (!item)
 		{
-			result->negate = true;
-			return result;
+			if (result)
+				RETURN_ERROR();
+
+			return NULL;
 		}
+
+		*tail = new_node_value(ps, n_list, item);
+		tail = &(*tail)->other;
 	}
+	while (is_next_comma(ps, error));
 
-	push_token(_t);
-	return is_expr_07(error);
-}
+	ON_ERROR_RETURN();
 
+	return result;
+}
 
 /*
- * Add operator AND
+ * ARRAY [ item [, ...] ]
+ *
+ * The keyword is NULL for nested arrays.
  *
  */
 static Node *
-is_expr_09(bool *error)
+is_array_constructor(PsParser *ps, bool *error, Token *keyword)
 {
-	Node	*result;
-
-	if (result = is_expr_08(error))
-	{
-		Token	t, *_t;
+	Token	t, *_t;
+	Node   *result;
 
-		ON_ERROR_RETURN();
+	if (keyword)
+		result = new_node_str(ps, n_array, keyword);
+	else
+		result = new_node(ps, n_array);
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
+	_t = next_token(ps, &t);
+	ON_EMPTY_RETURN_ERROR();
 
-		if (is_keyword(_t, k_AND))
-		{
-			Node   *expr = new_node_str(n_logical_and, _t);
+	if (_t->type != tt_lbracket)
+		RETURN_ERROR();
 
-			expr->value = result;
-			if (expr->other = is_expr_09(error))
-				return expr;
+	result->value = is_literal_array(ps, tt_rbracket);
+	if (!result->value)
+	{
+		/* ARRAY[] is allowed */
+		result->value = is_array_item_list(ps, error);
+		ON_ERROR_RETURN();
+	}
 
-			ON_ERROR_RETURN();
-			RETURN_ERROR();
-		}
+	_t = next_token(ps, &t);
+	ON_EMPTY_RETURN_ERROR();
 
-		push_token(_t);
+	if (_t->type != tt_rbracket)
+	{
+		parser_error(ps, PS_ERROR_SYNTAX, "unclosed bracket");
+		RETURN_ERROR();
 	}
 
 	return result;
 }
 
 /*
- * Add operator OR
- *
+ * Parses end of content of parenthesis. The expr is first expression,
+ * it can be followed by other expressions of composite value.
  */
 static Node *
-is_expr_10(bool *error)
+close_parenthesis(PsParser *ps, bool *error, Node *expr)
 {
-	Node	*result;
+	Token	t, *_t;
+	Node   *composite = NULL;
 
-	if (result = is_expr_09(error))
-	{
-		Token	t, *_t;
+	_t = next_token(ps, &t);
+	ON_EMPTY_RETURN_ERROR();
 
+	if (_t->type == tt_comma)
+	{
+		composite = new_node_value(ps, n_composite,
+					  new_node_value(ps, n_list, expr));
+		composite->value->other = is_expr_list(ps, error);
 		ON_ERROR_RETURN();
 
-		_t = next_token(&t);
+		_t = next_token(ps, &t);
 		ON_EMPTY_RETURN_ERROR();
+	}
 
-		if (is_keyword(_t, k_OR))
-		{
-			Node   *expr = new_node_str(n_logical_or, _t);
-
-			expr->value = result;
-			if (expr->other = is_expr_10(error))
-				return expr;
+	if (_t->type != tt_rparent)
+	{
+		parser_error(ps, PS_ERROR_SYNTAX, "unclosed parenthesis");
+		RETURN_ERROR();
+	}
 
-			ON_ERROR_RETURN();
-			RETURN_ERROR();
-		}
+	if (composite)
+		return composite;
 
-		push_token(_t);
-	}
+	/*
+	 * NOT and parenthesis on same node means NOT (expr), so negated
+	 * expression in parenthesis (NOT expr) should be wrapped.
+	 */
+	if ((expr->type != n_expr && expr->type != n_expr_wrapper) ||
+		expr->negate)
+		expr = new_node_value(ps, n_expr_wrapper, expr);
 
-	return result;
+	expr->parenthesis = true;
+	return expr;
 }
 
-#define	is_expr_top(e)		is_expr_10(e)
-
 /*
  * parses a) ( expr ) b) (SELECT ...), c (expr, expr, expr, ...)
  *
+ * The run of opening parenthesis is only counted, and the recursion
+ * is used only for content of innermost parenthesis. The parenthesized
+ * expression is first operand of expression of outer level, so the
+ * outer levels are parsed by loop, and deeply nested parenthesis
+ * doesn't need deep stack.
+ *
  */
 static Node *
-is_expr_in_parenthesis(bool *error)
+is_expr_in_parenthesis(PsParser *ps, bool *error)
 {
 	Token	t, *_t;
-	Node   *expr, *composite = NULL;
-	bool	is_subquery = false;
-
-	_t = next_token(&t);
-	ON_EMPTY_RETURN_ERROR();
+	Node   *expr;
+	int		nlevels = 0;
 
-	if (t.type != tt_lparent)
+	for (;;)
 	{
-		push_token(_t);
-		return NULL;
-	}
+		_t = next_token(ps, &t);
+		ON_EMPTY_RETURN_ERROR();
 
-	expr = is_query(error);
-	ON_ERROR_RETURN();
+		if (_t->type != tt_lparent)
+		{
+			push_token(ps, _t);
+			break;
+		}
 
-	if (!expr)
-	{
-		expr = is_expr_top(error);
-		ON_ERROR_RETURN();
+		nlevels += 1;
 	}
 
-	if (!expr)
+	if (nlevels == 0)
 		return NULL;
 
-	_t = next_token(&t);
-	ON_EMPTY_RETURN_ERROR();
+	/* list of constants */
+	expr = is_literal_array(ps, tt_rparent);
+	if (expr)
+	{
+		/* the closing parenthesis is checked by is_literal_array */
+		_t = next_token(ps, &t);
+		ON_EMPTY_RETURN_ERROR();
 
-	if (t.type == tt_comma)
+		expr = new_node_value(ps, n_composite, expr);
+	}
+	else
 	{
-		composite = new_node_value(n_composite,
-					  new_node_value(n_list, expr));
-		composite->value->other = is_expr_list(error);
+		expr = is_query(ps, error);
 		ON_ERROR_RETURN();
 
-		_t = next_token(&t);
-	}
+		if (!expr)
+		{
+			expr = is_expr_top(ps, error);
+			ON_ERROR_RETURN();
+		}
 
-	if (t.type != tt_rparent)
-	{
-		fprintf(stderr, "unclosed parenthesis\n");
-		RETURN_ERROR();
+		if (!expr)
+			return NULL;
+
+		expr = close_parenthesis(ps, error, expr);
+		ON_ERROR_RETURN();
 	}
 
-	if (composite)
-		return composite;
+	while (--nlevels > 0)
+	{
+		expr = is_expr_top_continue(ps, error, expr);
+		ON_ERROR_RETURN();
 
-	if (expr->type != n_expr && expr->type != n_expr_wrapper)
-		expr = new_node_value(n_expr_wrapper, expr);
+		expr = close_parenthesis(ps, error, expr);
+		ON_ERROR_RETURN();
+	}
 
-	expr->parenthesis = true;
 	return expr;
 }
 
 /*
  * expr [, expr ...]
  *
- * returns list of expr nodes.
+ * returns list of expressions.
  *
  */
 static Node *
-is_expr_list(bool *error)
+is_expr_list(PsParser *ps, bool *error)
 {
-	Node   *expr;
+	Node   *result = NULL;
+	Node  **tail = &result;
 
-	if (expr = is_expr_top(error))
+	do
 	{
-		Token	t, *_t;
-		Node   *result;
+		Node   *expr;
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
-
-		result = new_node_value(n_expr, expr);
+		expr = is_expr_top(ps, error);
+		ON_ERROR_RETURN();
 
-		if (t.type == tt_comma)
+		/* the expression is required after comma */
+		if (!expr)
 		{
-			if (result->other = is_expr_list(error))
-				return result;
+			if (result)
+				RETURN_ERROR();
 
-			ON_ERROR_RETURN();
-			RETURN_ERROR();
+			return NULL;
 		}
 
-		push_token(_t);
-		return result;
+		*tail = new_node_value(ps, n_list, expr);
+		tail = &(*tail)->other;
 	}
+	while (is_next_comma(ps, error));
 
-	return NULL;
+	ON_ERROR_RETURN();
+
+	return result;
 }
 
 /*
@@ -805,30 +1131,30 @@ is_expr_list(bool *error)
  *
  */
 static Node *
-is_label(bool *error)
+is_label(PsParser *ps, bool *error)
 {
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
-	if (t.type == tt_keyword && t.value == k_AS)
+	if (_t->type == tt_keyword && _t->value == k_AS)
 	{
 		Token	t2, *_t2;
 
-		_t2 = next_token(&t2);
+		_t2 = next_token(ps, &t2);
 		ON_EMPTY_RETURN_ERROR();
 
 		if (is_enhanced_ident(_t2))
-			return new_node_str(n_labeled_expr, _t2);
+			return new_node_str(ps, n_labeled_expr, _t2);
 
 		RETURN_ERROR();
 	}
 
 	if (is_enhanced_ident(_t))
-		return new_node_str(n_labeled_expr, _t);
+		return new_node_str(ps, n_labeled_expr, _t);
 
-	push_token(_t);
+	push_token(ps, _t);
 
 	return NULL;
 }
@@ -840,54 +1166,50 @@ is_label(bool *error)
  *
  */
 static Node *
-is_labeled_expr_list(bool *error)
+is_labeled_expr_list(PsParser *ps, bool *error)
 {
-	Token	t, *_t;
-	Node   *node;
-
-	node = is_qualified_star(error);
-	ON_ERROR_RETURN();
-
-	if (!node)
-	{
-		node = is_expr_top(error);
-		ON_ERROR_RETURN();
-	}
+	Node   *result = NULL;
+	Node  **tail = &result;
 
-	if (node)
+	do
 	{
-		Token	t, *_t;
+		Node   *node;
 		Node   *label;
-		Node   *result;
 
-		label = is_label(error);
+		node = is_qualified_star(ps, error);
 		ON_ERROR_RETURN();
 
-		if (label)
+		if (!node)
 		{
-			label->value = node;
-			node = label;
+			node = is_expr_top(ps, error);
+			ON_ERROR_RETURN();
 		}
 
-		result = new_node_value(n_list, node);
+		if (!node)
+		{
+			if (result)
+				RETURN_ERROR();
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
+			return NULL;
+		}
 
-		if (t.type == tt_comma)
-		{
-			if (result->other = is_labeled_expr_list(error))
-				return result;
+		label = is_label(ps, error);
+		ON_ERROR_RETURN();
 
-			ON_ERROR_RETURN();
-			RETURN_ERROR();
+		if (label)
+		{
+			label->value = node;
+			node = label;
 		}
 
-		push_token(_t);
-		return result;
+		*tail = new_node_value(ps, n_list, node);
+		tail = &(*tail)->other;
 	}
+	while (is_next_comma(ps, error));
 
-	return NULL;
+	ON_ERROR_RETURN();
+
+	return result;
 }
 
 
@@ -896,28 +1218,28 @@ is_labeled_expr_list(bool *error)
  *
  */
 static Node *
-is_name(bool *error)
+is_name(PsParser *ps, bool *error)
 {
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
-	if (t.type == tt_ident ||
-			(t.type == tt_keyword && !t.reserved))
+	if (_t->type == tt_ident ||
+			(_t->type == tt_keyword && !_t->reserved))
 	{
 		Token	t2, *_t2;
 
-		_t2 = next_token(&t2);
+		_t2 = next_token(ps, &t2);
 		ON_EMPTY_RETURN_ERROR();
 
-		if (t2.type == tt_named_expr)
-			return new_node_str(n_named_expr, _t);
+		if (_t2->type == tt_named_expr)
+			return new_node_str(ps, n_named_expr, _t);
 
-		push_token(_t2);
+		push_token(ps, _t2);
 	}
 
-	push_token(_t);
+	push_token(ps, _t);
 	return NULL;
 }
 
@@ -928,46 +1250,43 @@ is_name(bool *error)
  *
  */
 static Node *
-is_named_expr_list(bool *error)
+is_named_expr_list(PsParser *ps, bool *error)
 {
-	Node   *node;
-	Node   *expr;
-
-	node = is_name(error);
-	ON_ERROR_RETURN();
-
-	expr = is_expr_top(error);
-	ON_ERROR_RETURN();
-
-	if (node)
-		node->value = expr;
-	else
-		node = expr;
+	Node   *result = NULL;
+	Node  **tail = &result;
 
-	if (node)
+	do
 	{
-		Token	t, *_t;
-		Node   *result;
+		Node   *node;
+		Node   *expr;
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
+		node = is_name(ps, error);
+		ON_ERROR_RETURN();
+
+		expr = is_expr_top(ps, error);
+		ON_ERROR_RETURN();
 
-		result = new_node_value(n_list, node);
+		if (node)
+			node->value = expr;
+		else
+			node = expr;
 
-		if (t.type == tt_comma)
+		if (!node)
 		{
-			if (result->other = is_named_expr_list(error))
-				return result;
+			if (result)
+				RETURN_ERROR();
 
-			ON_ERROR_RETURN();
-			RETURN_ERROR();
+			return NULL;
 		}
 
-		push_token(_t);
-		return result;
+		*tail = new_node_value(ps, n_list, node);
+		tail = &(*tail)->other;
 	}
+	while (is_next_comma(ps, error));
 
-	return NULL;
+	ON_ERROR_RETURN();
+
+	return result;
 }
 
 /*
@@ -975,34 +1294,33 @@ is_named_expr_list(bool *error)
  *
  */
 static Node *
-is_function_args(bool *error)
+is_function_args(PsParser *ps, bool *error)
 {
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
-	if (t.type == tt_lparent)
+	if (_t->type == tt_lparent)
 	{
 		Token	t2, *_t2;
-		bool	has_args;
 		Node   *result;
 
-		result = new_node_value(n_function,
-								is_named_expr_list(error));
+		result = new_node_value(ps, n_function,
+								is_named_expr_list(ps, error));
 		ON_ERROR_RETURN();
 
-		_t2 = next_token(&t2);
+		_t2 = next_token(ps, &t2);
 		ON_EMPTY_RETURN_ERROR();
 
-		if (t2.type == tt_rparent)
+		if (_t2->type == tt_rparent)
 			return result;
 
-		fprintf(stderr, "unclosed parenthesis\n");
+		parser_error(ps, PS_ERROR_SYNTAX, "unclosed parenthesis");
 		RETURN_ERROR();
 	}
 
-	push_token(_t);
+	push_token(ps, _t);
 	return NULL;
 }
 
@@ -1012,31 +1330,30 @@ is_function_args(bool *error)
  *****************************************************************/
 
 static Node *
-is_relation_source(bool *error)
+is_relation_source(PsParser *ps, bool *error)
 {
 	Node   *result;
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
-	if (t.type == tt_lparent)
+	if (_t->type == tt_lparent)
 	{
-		Node   *label;
-
-		_t = next_token(&t);
+		_t = next_token(ps, &t);
 		ON_EMPTY_RETURN_ERROR();
 
-		if (is_keyword(_t, k_SELECT))
+		if (is_keyword(_t, k_SELECT) || is_keyword(_t, k_VALUES))
 		{
-			push_token(_t);
-			result = is_query(error);
+			push_token(ps, _t);
+			result = is_query(ps, error);
 		}
 		else
 		{
-			push_token(_t);
-			result = is_relation_expr(error, true, NULL);
-			result->relexpr_parenthesis = true;
+			push_token(ps, _t);
+			result = is_relation_expr(ps, error, true, NULL);
+			if (result)
+				result->relexpr_parenthesis = true;
 		}
 		ON_ERROR_RETURN();
 
@@ -1044,19 +1361,19 @@ is_relation_source(bool *error)
 		if (!result)
 			RETURN_ERROR();
 
-		_t = next_token(&t);
+		_t = next_token(ps, &t);
 		ON_EMPTY_RETURN_ERROR();
 
-		if (t.type != tt_rparent)
+		if (_t->type != tt_rparent)
 		{
-			fprintf(stderr, "unclosed parenthesis\n");
+			parser_error(ps, PS_ERROR_SYNTAX, "unclosed parenthesis");
 			RETURN_ERROR();
 		}
 	}
 	else
 	{
-		push_token(_t);
-		result = is_qualified_ident(error);
+		push_token(ps, _t);
+		result = is_qualified_ident(ps, error);
 		ON_ERROR_RETURN();
 	}
 
@@ -1068,22 +1385,22 @@ is_relation_source(bool *error)
  *
  */
 static Node *
-is_relation_label(bool *error)
+is_relation_label(PsParser *ps, bool *error)
 {
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
-	if (t.type == tt_keyword && t.value == k_AS)
+	if (_t->type == tt_keyword && _t->value == k_AS)
 	{
 		Token	t2, *_t2;
 
-		_t2 = next_token(&t2);
+		_t2 = next_token(ps, &t2);
 		ON_EMPTY_RETURN_ERROR();
 
 		if (is_enhanced_ident(_t2))
-			return new_node_str(n_labeled_expr, _t2);
+			return new_node_str(ps, n_labeled_expr, _t2);
 
 		RETURN_ERROR();
 	}
@@ -1093,9 +1410,9 @@ is_relation_label(bool *error)
 			&& !is_keyword(_t, k_USING)
 			&& !is_join_keyword(_t)
 			&& is_enhanced_ident(_t))
-		return new_node_str(n_labeled_expr, _t);
+		return new_node_str(ps, n_labeled_expr, _t);
 
-	push_token(_t);
+	push_token(ps, _t);
 
 	return NULL;
 }
@@ -1105,18 +1422,18 @@ is_relation_label(bool *error)
  *
  */
 static Node *
-is_relation(bool *error)
+is_relation(PsParser *ps, bool *error)
 {
 	Node   *result;
 
-	result = is_relation_source(error);
+	result = is_relation_source(ps, error);
 	ON_ERROR_RETURN();
 
 	if (result)
 	{
 		Node   *label;
 
-		label = is_relation_label(error);
+		label = is_relation_label(ps, error);
 		ON_ERROR_RETURN();
 
 		if (label)
@@ -1160,35 +1477,35 @@ is_join_keyword(Token *t)
  *
  */
 static Node *
-is_ident_list(bool *error)
+is_ident_list(PsParser *ps, bool *error)
 {
 	Token	t, *_t;
 	Node   *result = NULL;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
 	if (is_enhanced_ident(_t))
 	{
-		Node    *ident = new_node_str(n_ident, _t);
+		Node    *ident = new_node_str(ps, n_ident, _t);
 
-		result = new_node_value(n_list, ident);
+		result = new_node_value(ps, n_list, ident);
 
-		_t = next_token(&t);
+		_t = next_token(ps, &t);
 		ON_EMPTY_RETURN_ERROR();
 
-		if (t.type == tt_comma)
+		if (_t->type == tt_comma)
 		{
-			result->other = is_relation_expr_list(error);
+			result->other = is_relation_expr_list(ps, error);
 			ON_ERROR_RETURN();
 			if (!result->other)
 				RETURN_ERROR();
 		}
 		else
-			push_token(_t);
+			push_token(ps, _t);
 	}
 	else
-		push_token(_t);
+		push_token(ps, _t);
 
 	return result;
 }
@@ -1198,30 +1515,30 @@ is_ident_list(bool *error)
  *
  */
 static Node *
-is_ident_p_list(bool *error)
+is_ident_p_list(PsParser *ps, bool *error)
 {
 	Token	t, *_t;
 	Node   *result = NULL;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
-	if (t.type == tt_lparent)
+	if (_t->type == tt_lparent)
 	{
-		result = is_ident_list(error);
+		result = is_ident_list(ps, error);
 		ON_ERROR_RETURN();
 
-		_t = next_token(&t);
+		_t = next_token(ps, &t);
 		ON_EMPTY_RETURN_ERROR();
 
-		if (t.type != tt_rparent)
+		if (_t->type != tt_rparent)
 		{
-			fprintf(stderr, "unclosed parenthesis\n");
+			parser_error(ps, PS_ERROR_SYNTAX, "unclosed parenthesis");
 			RETURN_ERROR();
 		}
 	}
 	else
-		push_token(_t);
+		push_token(ps, _t);
 
 	return result;
 }
@@ -1232,15 +1549,13 @@ is_ident_p_list(bool *error)
  *
  */
 static Node *
-is_relation_expr(bool *error, bool join_required, Node *leftrel)
+_is_relation_expr(PsParser *ps, bool *error, bool join_required, Node *leftrel)
 {
 	Node   *result;
-	bool	parenthesis = false;
-	Token	t, *_t;
 
 	if (!leftrel)
 	{
-		result = is_relation(error);
+		result = is_relation(ps, error);
 		ON_ERROR_RETURN();
 	}
 	else
@@ -1250,37 +1565,37 @@ is_relation_expr(bool *error, bool join_required, Node *leftrel)
 	{
 		Token	t, *_t;
 
-		_t = next_token(&t);
+		_t = next_token(ps, &t);
 		ON_EMPTY_RETURN_ERROR();
 
 		if (is_join_keyword(_t))
 		{
-			Node   *expr = new_node(n_join);
+			Node   *expr = new_node(ps, n_join);
 
 			expr->left = result;
-			expr->jointype = t.value;
-			expr->is_natural = t.natural_join;
+			expr->jointype = _t->value;
+			expr->is_natural = _t->natural_join;
 
-			expr->right = is_relation_expr(error, false, NULL);
+			expr->right = is_relation_expr(ps, error, false, NULL);
 			ON_ERROR_RETURN();
 
 			if (expr->right)
 			{
 				if (!expr->is_natural && expr->jointype != k_CROSS_JOIN)
 				{
-					_t = next_token(&t);
+					_t = next_token(ps, &t);
 					ON_EMPTY_RETURN_ERROR();
 
 					if (is_keyword(_t, k_ON))
 					{
-						expr->onexpr = is_expr_top(error);
+						expr->onexpr = is_expr_top(ps, error);
 						ON_ERROR_RETURN();
 						if (!expr->onexpr)
 							RETURN_ERROR();
 					}
 					else if (is_keyword(_t, k_USING))
 					{
-						expr->using = is_ident_p_list(error);
+						expr->using = is_ident_p_list(ps, error);
 						ON_ERROR_RETURN();
 						if (!expr->using)
 							RETURN_ERROR();
@@ -1289,16 +1604,16 @@ is_relation_expr(bool *error, bool join_required, Node *leftrel)
 						RETURN_ERROR();
 				}
 
-				_t = next_token(&t);
+				_t = next_token(ps, &t);
 				ON_EMPTY_RETURN_ERROR();
 
 				if (is_join_keyword(_t))
 				{
-					push_token(_t);
-					expr = is_relation_expr(error, true, expr);
+					push_token(ps, _t);
+					expr = is_relation_expr(ps, error, true, expr);
 				}
 				else
-					push_token(_t);
+					push_token(ps, _t);
 			}
 			else
 				RETURN_ERROR();
@@ -1307,7 +1622,7 @@ is_relation_expr(bool *error, bool join_required, Node *leftrel)
 		}
 		else
 		{
-			push_token(_t);
+			push_token(ps, _t);
 			if (join_required)
 				RETURN_ERROR();
 		}
@@ -1319,34 +1634,34 @@ is_relation_expr(bool *error, bool join_required, Node *leftrel)
 }
 
 static Node *
-is_relation_expr_list(bool *error)
+is_relation_expr_list(PsParser *ps, bool *error)
 {
-	Node   *re;
+	Node   *result = NULL;
+	Node  **tail = &result;
 
-	re = is_relation_expr(error, false, NULL);
-	if (re)
+	do
 	{
-		Token	t, *_t;
-		Node   *result;
+		Node   *re;
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
+		re = is_relation_expr(ps, error, false, NULL);
+		ON_ERROR_RETURN();
 
-		result = new_node_value(n_list, re);
-		if (t.type == tt_comma)
+		if (!re)
 		{
-			if (result->other = is_relation_expr_list(error))
-				return result;
+			if (result)
+				RETURN_ERROR();
 
-			ON_ERROR_RETURN();
-			RETURN_ERROR();
+			return NULL;
 		}
 
-		push_token(_t);
-		return result;
+		*tail = new_node_value(ps, n_list, re);
+		tail = &(*tail)->other;
 	}
+	while (is_next_comma(ps, error));
 
-	return NULL;
+	ON_ERROR_RETURN();
+
+	return result;
 }
 
 static bool
@@ -1389,159 +1704,193 @@ check_order_by_flags(Token *token, Node *node, bool *error)
  *
  */
 static Node *
-is_order_by_expr(bool *error)
+is_order_by_expr(PsParser *ps, bool *error)
 {
 	Node   *result;
 	Token	t, *_t;
 
-	result = is_expr_top(error);
+	result = is_expr_top(ps, error);
 	ON_ERROR_RETURN();
 
-	_t = next_token(&t);
+	if (!result)
+		return NULL;
+
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
 	/* we should to assign following flags to expr only */
 	if (result->type != n_expr && result->type != n_expr_wrapper)
-		result = new_node_value(n_expr_wrapper, result);
+		result = new_node_value(ps, n_expr_wrapper, result);
 
 	if (check_order_by_flags(_t, result, error))
 	{
 		ON_ERROR_RETURN();
 
-		_t = next_token(&t);
+		_t = next_token(ps, &t);
 		ON_EMPTY_RETURN_ERROR();
 
 		if (!check_order_by_flags(_t, result, error))
-			push_token(_t);
+			push_token(ps, _t);
 
 		ON_ERROR_RETURN();
 	}
 	else
-		push_token(_t);
+		push_token(ps, _t);
 
 	return result;
 }
 
 static Node *
-is_order_by_expr_list(bool *error)
+is_order_by_expr_list(PsParser *ps, bool *error)
 {
-	Node   *expr, *result = NULL;
-	Token	t, *_t;
-
-	expr = is_order_by_expr(error);
-	ON_ERROR_RETURN();
+	Node   *result = NULL;
+	Node  **tail = &result;
 
-	if (expr)
+	do
 	{
-		Token	t, *_t;
-
-		result = new_node_value(n_list, expr);
+		Node   *expr;
 
-		_t = next_token(&t);
-		ON_EMPTY_RETURN_ERROR();
+		expr = is_order_by_expr(ps, error);
+		ON_ERROR_RETURN();
 
-		if (t.type == tt_comma)
+		if (!expr)
 		{
-			result->other = is_order_by_expr_list(error);
-			ON_ERROR_RETURN();
-			if (!result->other)
+			if (result)
 				RETURN_ERROR();
+
+			return NULL;
 		}
-		else
-			push_token(_t);
+
+		*tail = new_node_value(ps, n_list, expr);
+		tail = &(*tail)->other;
 	}
+	while (is_next_comma(ps, error));
+
+	ON_ERROR_RETURN();
 
 	return result;
 }
 
 static Node *
-is_order_by_clause(bool *error)
+is_order_by_clause(PsParser *ps, bool *error)
 {
 	Node *result = NULL;
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
 	if (is_keyword(_t, k_ORDER_BY))
 	{
-		result = is_order_by_expr_list(error);
+		result = is_order_by_expr_list(ps, error);
 		ON_ERROR_RETURN();
 
 		if (!result)
 			RETURN_ERROR();
 	}
 	else
-		push_token(_t);
+		push_token(ps, _t);
 
 	return result;
 }
 
 static Node *
-is_from_clause(bool *error)
+is_from_clause(PsParser *ps, bool *error)
 {
 	Node *result = NULL;
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
 	if (is_keyword(_t, k_FROM))
 	{
-		result = is_relation_expr_list(error);
+		result = is_relation_expr_list(ps, error);
 		ON_ERROR_RETURN();
 
 		if (!result)
 			RETURN_ERROR();
 	}
 	else
-		push_token(_t);
+		push_token(ps, _t);
 
 	return result;
 }
 
 static Node *
-is_expr_clause(bool *error, KeywordValue req)
+is_expr_clause(PsParser *ps, bool *error, KeywordValue req)
 {
 	Node *result = NULL;
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
 	if (is_keyword(_t, req))
 	{
-		result = is_expr_top(error);
+		result = is_expr_top(ps, error);
 		ON_ERROR_RETURN();
 
 		if (!result)
 			RETURN_ERROR();
 	}
 	else
-		push_token(_t);
+		push_token(ps, _t);
 
 	return result;
 }
 
 static Node *
-is_group_by_clause(bool *error)
+is_group_by_clause(PsParser *ps, bool *error)
 {
 	Node *result = NULL;
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
 	if (is_keyword(_t, k_GROUP_BY))
 	{
-		result = is_expr_list(error);
+		result = is_expr_list(ps, error);
 		ON_ERROR_RETURN();
 
 		if (!result)
 			RETURN_ERROR();
 	}
 	else
-		push_token(_t);
+		push_token(ps, _t);
+
+	return result;
+}
+
+/*
+ * ( expr [, ...] ) [, ...]
+ *
+ * returns list of rows of VALUES
+ *
+ */
+static Node *
+is_values_rows(PsParser *ps, bool *error)
+{
+	Node   *result = NULL;
+	Node  **tail = &result;
+
+	do
+	{
+		Node   *row;
+
+		row = is_expr_in_parenthesis(ps, error);
+		ON_ERROR_RETURN();
+
+		if (!row)
+			RETURN_ERROR();
+
+		*tail = new_node_value(ps, n_list, row);
+		tail = &(*tail)->other;
+	}
+	while (is_next_comma(ps, error));
+
+	ON_ERROR_RETURN();
 
 	return result;
 }
@@ -1551,175 +1900,733 @@ is_group_by_clause(bool *error)
  *
  */
 static Node *
-is_query(bool *error)
+_is_query(PsParser *ps, bool *error)
 {
 	Node   *result = NULL;
 	Token	t, *_t;
 
-	_t = next_token(&t);
+	_t = next_token(ps, &t);
 	ON_EMPTY_RETURN_ERROR();
 
 	if (is_keyword(_t, k_SELECT))
 	{
-		Node   *cols = is_labeled_expr_list(error);
+		Node   *cols = is_labeled_expr_list(ps, error);
 
 		ON_ERROR_RETURN();
 
-		result = new_node(n_query);
+		result = new_node(ps, n_query);
 		result->columns = cols;
 
-		result->from = is_from_clause(error);
+		result->from = is_from_clause(ps, error);
 		ON_ERROR_RETURN();
 
-		result->where = is_expr_clause(error, k_WHERE);
+		result->where = is_expr_clause(ps, error, k_WHERE);
 		ON_ERROR_RETURN();
 
-		result->group_by = is_group_by_clause(error);
+		result->group_by = is_group_by_clause(ps, error);
 		ON_ERROR_RETURN();
 
-		result->having = is_expr_clause(error, k_HAVING);
+		result->having = is_expr_clause(ps, error, k_HAVING);
 		ON_ERROR_RETURN();
 
-		result->order_by = is_order_by_clause(error);
+		result->order_by = is_order_by_clause(ps, error);
 		ON_ERROR_RETURN();
 
-		result->limit = is_expr_clause(error, k_LIMIT);
+		result->limit = is_expr_clause(ps, error, k_LIMIT);
 		ON_ERROR_RETURN();
 
-		result->offset = is_expr_clause(error, k_OFFSET);
+		result->offset = is_expr_clause(ps, error, k_OFFSET);
+		ON_ERROR_RETURN();
+	}
+	else if (is_keyword(_t, k_VALUES))
+	{
+		Token	t2, *_t2;
+		Node   *rows;
+
+		/* VALUES is not reserved keyword, it can be column name */
+		_t2 = next_token(ps, &t2);
+		ON_EMPTY_RETURN_ERROR();
+
+		push_token(ps, _t2);
+
+		if (_t2->type != tt_lparent)
+		{
+			push_token(ps, _t);
+			return NULL;
+		}
+
+		rows = is_values_rows(ps, error);
+		ON_ERROR_RETURN();
+
+		/* VALUES is query without FROM, WHERE, GROUP BY and HAVING */
+		result = new_node(ps, n_query);
+		result->columns = new_node_value(ps, n_values, rows);
+
+		result->order_by = is_order_by_clause(ps, error);
+		ON_ERROR_RETURN();
+
+		result->limit = is_expr_clause(ps, error, k_LIMIT);
+		ON_ERROR_RETURN();
+
+		result->offset = is_expr_clause(ps, error, k_OFFSET);
 		ON_ERROR_RETURN();
 	}
 	else
-		push_token(_t);
+		push_token(ps, _t);
 
 	return result;
 }
 
 
 static void
-debug_display_qident(Node *node)
+debug_display_qident(PsOutput *out, Node *node)
 {
 	bool first = true;
 
 	while (node)
 	{
 		if (!first)
-			fprintf(stderr, ".");
+			output_char(out, '.');
 		else
 			first = false;
 
-		fprintf(stderr, "%.*s", node->bytes, node->str);
+		output_write(out, node->str, node->bytes);
 		node = node->other;
 	}
 }
 
 /*
- * For effective work with nodes, we alloc memory in one block
+ * For effective work with nodes, we alloc memory in blocks. The size
+ * of blocks grows geometrically, so short queries doesn't touch more
+ * memory than they need, and large queries doesn't need too much
+ * allocations. The header of block and nodes are allocated together.
+ *
+ * Mapped block uses all mapped memory, so with huge pages the first
+ * block has whole huge page (2MB), and the sequence starts there.
  */
+#define NODE_BLOCK_MIN_SIZE		64
+#define NODE_BLOCK_MAX_SIZE		(64 * 1024)
+
+#define HUGE_PAGE_SIZE			(2 * 1024 * 1024)
+
 static NodeAllocator *
-node_allocator_init_block()
+node_allocator_init_block(PsParser *ps, int size)
 {
-	NodeAllocator *na = malloc(sizeof(NodeAllocator));
+	NodeAllocator *na = NULL;
+	size_t	bytes = sizeof(NodeAllocator) + (size_t) size * sizeof(Node);
+	size_t	mapped = 0;
 
-	if (!na)
-		out_of_memory();
+	if (ps->mmap_nodes)
+	{
+		void   *ptr = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+		if (ps->huge_pages)
+		{
+			mapped = (bytes + HUGE_PAGE_SIZE - 1) & ~((size_t) HUGE_PAGE_SIZE - 1);
+			ptr = mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+					   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		}
+#endif
+
+		/* huge pages are not available, use default page size */
+		if (ptr == MAP_FAILED)
+		{
+			size_t	pagesize = (size_t) sysconf(_SC_PAGESIZE);
+
+			mapped = (bytes + pagesize - 1) & ~(pagesize - 1);
+			ptr = mmap(NULL, mapped, PROT_READ | PROT_WRITE,
+					   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		}
+
+		if (ptr == MAP_FAILED)
+			out_of_memory();
+
+		na = ptr;
 
-	na->size = 1000;		/* 10000 nodes */
-	na->nodes = malloc(na->size * sizeof(Node));
-	if (!na->nodes)
-		out_of_memory();
+		/* use all mapped memory */
+		size = (mapped - sizeof(NodeAllocator)) / sizeof(Node);
+	}
+	else
+	{
+		na = malloc(bytes);
+		if (!na)
+			out_of_memory();
+	}
 
+	/* nodes are zeroed by new_node */
+	na->nodes = (Node *) (na + 1);
+	na->size = size;
 	na->used = 0;
-	memset(na->nodes, 0, na->size * sizeof(Node));
+	na->mapped = mapped;
+	na->next = NULL;
 
 	return na;
 }
 
-static void
-init_node_allocator()
-{
-	root_allocator = node_allocator_init_block();
-	current_allocator = root_allocator;
-}
-
+/*
+ * Returns n consecutive slots of current block. When the next block
+ * is too small for them, then new block is inserted before it.
+ */
 static Node *
-new_node(NodeType type)
+alloc_nodes(PsParser *ps, int n)
 {
+	NodeAllocator *na = ps->current_allocator;
 	Node *result;
 
-	if (current_allocator->used >= current_allocator->size)
+	if (!na)
 	{
-		NodeAllocator *n = node_allocator_init_block();
+		na = ps->root_allocator =
+			node_allocator_init_block(ps, n > NODE_BLOCK_MIN_SIZE ? n : NODE_BLOCK_MIN_SIZE);
+		ps->current_allocator = na;
+	}
+
+	if (na->used + n > na->size)
+	{
+		/* blocks are reused after reset or release */
+		if (!na->next || na->next->size < n)
+		{
+			NodeAllocator *next = na->next;
+			int		size = na->size * 2;
+
+			if (size > NODE_BLOCK_MAX_SIZE)
+				size = NODE_BLOCK_MAX_SIZE;
+			if (size < n)
+				size = n;
+
+			na->next = node_allocator_init_block(ps, size);
+			na->next->next = next;
+		}
+
+		na = ps->current_allocator = na->next;
+	}
+
+	result = &na->nodes[na->used];
+	na->used += n;
+
+	if (ps->budget_jmp)
+	{
+		ps->statement_nodes += n;
 
-		current_allocator->next = n;
-		current_allocator = n;
+		if (ps->budget.max_nodes > 0 &&
+			ps->statement_nodes > ps->budget.max_nodes)
+			budget_exceeded(ps, PS_ERROR_TOO_MANY_NODES,
+							"statement needs too many nodes (max nodes is %lld)",
+							(long long) ps->budget.max_nodes);
 	}
 
-	result = &current_allocator->nodes[current_allocator->used++];
+	return result;
+}
+
+static Node *
+new_node(PsParser *ps, NodeType type)
+{
+	Node *result = alloc_nodes(ps, 1);
+
+	memset(result, 0, sizeof(Node));
 	result->type = type;
+
+	if (ps->stats)
+		ps->stats->nodes[type] += 1;
+
 	return result;
 }
 
+/*
+ * Returns memory for arrays of nodes (operands, literals). The memory
+ * is allocated in node blocks, so it is released together with nodes.
+ */
+static void *
+new_node_memory(PsParser *ps, size_t bytes)
+{
+	int		nslots = (bytes + sizeof(Node) - 1) / sizeof(Node);
+
+	return alloc_nodes(ps, nslots);
+}
+
 /******************************************************
  *  Public API
  *
  ******************************************************/
+
+/*
+ * Releases all nodes, but the memory is not freed, and it will
+ * be used for nodes of next query. So the memory is limited by
+ * memory necessary for largest query.
+ */
+void
+reset_node_allocator(PsParser *ps)
+{
+	NodeAllocatorMark mark;
+
+	mark.block = ps->root_allocator;
+	mark.used = 0;
+
+	release_node_allocator(ps, mark);
+}
+
+/*
+ * Frees all memory used by nodes
+ */
+void
+free_node_allocator(PsParser *ps)
+{
+	NodeAllocator *na = ps->root_allocator;
+
+	while (na)
+	{
+		NodeAllocator *next = na->next;
+
+		if (na->mapped)
+			munmap(na, na->mapped);
+		else
+			free(na);
+
+		na = next;
+	}
+
+	ps->root_allocator = NULL;
+	ps->current_allocator = NULL;
+}
+
+/*
+ * Returns current position of allocator. Nodes allocated after
+ * this mark can be released by release_node_allocator.
+ */
+NodeAllocatorMark
+mark_node_allocator(PsParser *ps)
+{
+	NodeAllocatorMark mark;
+
+	mark.block = ps->current_allocator;
+	mark.used = mark.block ? mark.block->used : 0;
+
+	return mark;
+}
+
+/*
+ * Releases all nodes allocated after mark.
+ */
+void
+release_node_allocator(PsParser *ps, NodeAllocatorMark mark)
+{
+	NodeAllocator *na;
+
+	if (ps->stats)
+		update_allocator_stats(ps);
+
+	if (!mark.block)
+	{
+		/* nothing was allocated when mark was taken */
+		mark.block = ps->root_allocator;
+		mark.used = 0;
+
+		if (!mark.block)
+			return;
+	}
+
+	na = mark.block;
+	na->used = mark.used;
+
+	for (na = na->next; na && na->used > 0; na = na->next)
+		na->used = 0;
+
+	ps->current_allocator = mark.block;
+}
  
 /*
- * Returns true, when there are not any syntax error
- *
+ * Updates stats of node allocator. The stats hold maximal size of
+ * allocator and maximal number of used nodes (high-water mark), so
+ * it should be called before nodes are released.
+ */
+void
+update_allocator_stats(PsParser *ps)
+{
+	NodeAllocator *na;
+	int64_t		blocks = 0;
+	int64_t		bytes = 0;
+	int64_t		used = 0;
+	bool		is_used = true;
+
+	for (na = ps->root_allocator; na; na = na->next)
+	{
+		blocks += 1;
+		bytes += na->mapped > 0 ? na->mapped :
+			sizeof(NodeAllocator) + (size_t) na->size * sizeof(Node);
+
+		/* blocks after current block are free */
+		if (is_used)
+			used += na->used;
+		if (na == ps->current_allocator)
+			is_used = false;
+	}
+
+	if (blocks > ps->stats->allocator_blocks)
+		ps->stats->allocator_blocks = blocks;
+	if (bytes > ps->stats->allocator_bytes)
+		ps->stats->allocator_bytes = bytes;
+	if (used > ps->stats->nodes_high_water)
+		ps->stats->nodes_high_water = used;
+}
+
+/*
+ * Initialize parser context. All state of lexer and parser is
+ * stored there, so more contexts can be used concurrently.
+ */
+void
+init_psparser(PsParser *ps)
+{
+	memset(ps, 0, sizeof(PsParser));
+
+	ps->max_depth = PS_DEFAULT_MAX_DEPTH;
+}
+
+/*
+ * Frees all memory allocated by parser context. Nodes returned
+ * by parser cannot be used after this.
+ */
+void
+free_psparser(PsParser *ps)
+{
+	if (ps->stats)
+		update_allocator_stats(ps);
+
+	free_node_allocator(ps);
+
+	free(ps->tokens);
+	free(ps->line_starts);
+	free(ps->operands);
+
+	memset(ps, 0, sizeof(PsParser));
+}
+
+/*
+ * Starts checking of budgets of new statement, when some budget is
+ * set. Exceeded budget jumps to budget_jmp.
+ */
+static void
+start_budget(PsParser *ps, jmp_buf *budget_jmp)
+{
+	ps->statement_nodes = 0;
+	ps->statement_tokens = 0;
+
+	if (ps->budget.timeout > 0)
+		ps->deadline = stats_time() + ps->budget.timeout / 1000.0;
+	else
+		ps->deadline = 0.0;
+
+	ps->budget_jmp = budget_jmp;
+}
+
+static bool
+has_budget(PsParser *ps)
+{
+	return ps->budget.max_nodes > 0 ||
+		   ps->budget.max_tokens > 0 ||
+		   ps->budget.timeout > 0;
+}
+
+/*
+ * Parses query from input of lexer (initialized by init_lexer, and
+ * optionally tokenized by tokenize). Returns NULL when there is
+ * syntax error. Nodes of previously parsed queries are not released,
+ * use reset_node_allocator or release_node_allocator.
  */
 Node *
-parser(char *str, bool force8bit)
+parse_query(PsParser *ps)
 {
-	bool	error;
+	bool	error = false;
 	Node   *result = NULL;
 
-	init_lexer(str, force8bit);
-	init_node_allocator();
+	ps->depth = 0;
+	ps->noperands = 0;
 
-	result = is_query(&error);
+	result = is_query(ps, &error);
 
 	if (!error)
 	{
 		Token	t, *_t;
 
-		_t = next_token(&t);
+		_t = next_token(ps, &t);
 
 		/* ignore last semicolon */
-		if (_t && t.type == tt_semicolon)
-			_t = next_token(&t);
+		if (_t && _t->type == tt_semicolon)
+			_t = next_token(ps, &t);
 
-		if (!(_t && t.type == tt_EOF))
+		if (!(_t && _t->type == tt_EOF))
 		{
-			fprintf(stderr, "syntax error (not on the end)\n");
+			parser_error(ps, PS_ERROR_SYNTAX, "syntax error (not on the end)");
 			return NULL;
 		}
 	}
 	else
 	{
-		fprintf(stderr, "syntax error (parsing error)\n");
+		parser_error(ps, PS_ERROR_SYNTAX, "syntax error (parsing error)");
 		return NULL;
 	}
 
 	return result;
 }
 
+static Node *
+_parse_next_statement(PsParser *ps, bool *error)
+{
+	Node   *result;
+	double	start = 0.0;
+
+	for (;;)
+	{
+		bool	tokenized;
+
+		/* nodes of previous statement are released */
+		reset_node_allocator(ps);
+
+		if (ps->budget_jmp)
+			start_budget(ps, ps->budget_jmp);
+
+		if (ps->stats)
+			start = stats_time();
+
+		tokenized = tokenize_statement(ps);
+
+		if (ps->stats)
+			ps->stats->lex_time += stats_time() - start;
+
+		if (!tokenized)
+		{
+			*error = true;
+			return NULL;
+		}
+
+		if (ps->tokens[0].type == tt_EOF)
+			return NULL;
+
+		/* skip empty statements */
+		if (ps->tokens[0].type != tt_semicolon)
+			break;
+	}
+
+	if (ps->stats)
+	{
+		ps->stats->statements += 1;
+		start = stats_time();
+	}
+
+	result = parse_query(ps);
+	if (!result)
+		*error = true;
+
+	if (ps->stats)
+		ps->stats->parse_time += stats_time() - start;
+
+	return result;
+}
+
+/*
+ * Parses next statement of script (initialized by init_lexer). The
+ * tokens of statement are read to token array first, so after syntax
+ * error or exceeded budget the parsing continues by next statement.
+ * Nodes of previous statement are released. Returns NULL and error
+ * is false on the end of script.
+ */
+Node *
+parse_next_statement(PsParser *ps, bool *error)
+{
+	jmp_buf	budget_jmp;
+	Node   *result;
+
+	*error = false;
+	reset_parser_error(ps);
+
+	/* the statement with exceeded budget fails, but the script continues */
+	ps->budget_jmp = NULL;
+	if (has_budget(ps))
+	{
+		if (setjmp(budget_jmp) != 0)
+		{
+			ps->budget_jmp = NULL;
+
+			if (!ps->tokens_ready)
+				skip_statement(ps);
+
+			*error = true;
+			return NULL;
+		}
+
+		ps->budget_jmp = &budget_jmp;
+	}
+
+	result = _parse_next_statement(ps, error);
+
+	ps->budget_jmp = NULL;
+
+	return result;
+}
+
+/*
+ * Returns text of last statement read by parse_next_statement (with
+ * semicolon, when statement has it). It is used for displaying of
+ * statements, that cannot be parsed.
+ */
 void
-debug_display_node(Node *node, int indent)
+get_statement_text(PsParser *ps, char **str, size_t *len)
+{
+	size_t	start = ps->tokens_start;
+	size_t	end;
+
+	if (ps->tokens_ready)
+	{
+		Token  *last = &ps->tokens[ps->ntokens - 1];
+
+		/* EOF token has not any text */
+		if (last->type == tt_EOF && ps->ntokens > 1)
+			last -= 1;
+
+		end = last->type == tt_EOF ? start : last->offset + last->bytes;
+	}
+	else
+	{
+		/* lexer error, the statement is not closed */
+		end = ps->iend - ps->istr;
+	}
+
+	/* skip leading white chars */
+	while (start < end &&
+		   (ps->istr[start] == ' ' || ps->istr[start] == '\n' ||
+			ps->istr[start] == '\t' || ps->istr[start] == '\r'))
+		start++;
+
+	*str = ps->istr + start;
+	*len = end - start;
+}
+
+/*
+ * Returns NULL, when there is any syntax error
+ *
+ */
+Node *
+parser(PsParser *ps, char *str, size_t len, bool force8bit)
 {
+	jmp_buf	budget_jmp;
+	Node   *result = NULL;
+
+	reset_parser_error(ps);
+	init_lexer(ps, str, len, force8bit);
+
+	/* nodes of previous query are released */
+	reset_node_allocator(ps);
+
+	ps->budget_jmp = NULL;
+	if (has_budget(ps))
+	{
+		if (setjmp(budget_jmp) != 0)
+		{
+			ps->budget_jmp = NULL;
+			return NULL;
+		}
+
+		start_budget(ps, &budget_jmp);
+	}
+
+	if (!ps->token_array || tokenize(ps))
+		result = parse_query(ps);
+
+	ps->budget_jmp = NULL;
+
+	return result;
+}
+
+/*
+ * Returns true, when node is right operand of generic operator, that
+ * continues chain of generic operators a op (b op c). These chains
+ * are not limited by max_depth, so they should be processed by loop.
+ */
+bool
+is_operator_chain(Node *node)
+{
+	return node && node->type == n_expr &&
+		node->exprtype == expr_generic && node->other &&
+		!node->parenthesis && !node->negate && !node->negative;
+}
+
+const char *
+node_type_name(NodeType type)
+{
+	switch (type)
+	{
+		case n_null:
+			return "null";
+		case n_true:
+			return "true";
+		case n_false:
+			return "false";
+		case n_numeric:
+			return "numeric";
+		case n_string:
+			return "string";
+		case n_function:
+			return "function";
+		case n_ident:
+			return "ident";
+		case n_star:
+			return "star";
+		case n_expr:
+			return "expr";
+		case n_expr_wrapper:
+			return "expr_wrapper";
+		case n_named_expr:
+			return "named_expr";
+		case n_labeled_expr:
+			return "labeled_expr";
+		case n_list:
+			return "list";
+		case n_logical_and:
+			return "logical_and";
+		case n_logical_or:
+			return "logical_or";
+		case n_is_null:
+			return "is_null";
+		case n_is_not_null:
+			return "is_not_null";
+		case n_query:
+			return "query";
+		case n_composite:
+			return "composite";
+		case n_is:
+			return "is";
+		case n_join:
+			return "join";
+		case n_literal_array:
+			return "literal_array";
+		case n_array:
+			return "array";
+		case n_values:
+			return "values";
+	}
+
+	return "unknown";
+}
+
+void
+debug_display_node(PsOutput *out, Node *node, int indent)
+{
+	int		i;
+
 	if (!node)
 	{
-		fprintf(stderr, "%*s%s", indent, "", "** NULL node **\n");
+		output_indent(out, indent);
+		output_str(out, "** NULL node **\n");
 		return;
 	}
 
-	fprintf(stderr, "%*s", indent, "");
+	output_indent(out, indent);
 
 	if (node->type != n_join && node->type != n_query)
 	{
-		fprintf(stderr, "%s", node->negate ? "NOT " : "");
-		fprintf(stderr, "%s", node->negative ? "-" : "");
+		if (node->negate)
+			output_str(out, "NOT ");
+		if (node->negative)
+			output_char(out, '-');
 	}
 
 	switch (node->type)
@@ -1729,176 +2636,281 @@ debug_display_node(Node *node, int indent)
 		case n_null:
 		case n_false:
 		case n_true:
-			fprintf(stderr, "%.*s", node->bytes, node->str);
-			fprintf(stderr, "\n");
+			output_write(out, node->str, node->bytes);
+			output_char(out, '\n');
 			break;
 
 		case n_ident:
 		case n_star:
-			debug_display_qident(node);
-			fprintf(stderr, "\n");
+			debug_display_qident(out, node);
+			output_char(out, '\n');
 			break;
 
 		case n_is:
-			fprintf(stderr, "IS %.*s\n", node->bytes, node->str);
-			debug_display_node(node->value, indent + 4);
+			output_str(out, node->is_not ? "IS NOT " : "IS ");
+			output_write(out, node->str, node->bytes);
+			output_char(out, '\n');
+			debug_display_node(out, node->value, indent + 4);
 			break;
 
 		case n_function:
-			debug_display_qident(node->other);
-			fprintf(stderr, "(\n");
-			debug_display_node(node->value, indent + 4);
-			fprintf(stderr, "%*s)\n", indent, "");
+			debug_display_qident(out, node->other);
+			output_str(out, "(\n");
+			debug_display_node(out, node->value, indent + 4);
+			output_indent(out, indent);
+			output_str(out, ")\n");
 			break;
 
 		case n_named_expr:
-			fprintf(stderr, "%.*s => \n", node->bytes, node->str);
-			debug_display_node(node->value, indent + 4);
+			output_write(out, node->str, node->bytes);
+			output_str(out, " => \n");
+			debug_display_node(out, node->value, indent + 4);
 			break;
 
 		case n_labeled_expr:
-			fprintf(stderr, "%.*s AS\n", node->bytes, node->str);
-			debug_display_node(node->value, indent + 4);
+			output_write(out, node->str, node->bytes);
+			output_str(out, " AS\n");
+			debug_display_node(out, node->value, indent + 4);
 			break;
 
 		case n_composite:
-			fprintf(stderr, "C(\n");
-			debug_display_node(node->value, indent + 4);
-			fprintf(stderr, "%*s%s\n", indent, "", ")");
+			output_str(out, "C(\n");
+			debug_display_node(out, node->value, indent + 4);
+			output_indent(out, indent);
+			output_str(out, ")\n");
 			break;
 
 		case n_list:
-			fprintf(stderr, "{\n");
+			output_str(out, "{\n");
 			do
 			{
-				debug_display_node(node->value, indent + 4);
+				debug_display_node(out, node->value, indent + 4);
 				node = node->other;
 			} while (node);
-			fprintf(stderr, "%*s}\n", indent, "");
+			output_indent(out, indent);
+			output_str(out, "}\n");
+			break;
+
+		case n_literal_array:
+			/* displayed like list of literals */
+			output_str(out, "{\n");
+			for (i = 0; i < node->nargs; i++)
+			{
+				output_indent(out, indent + 4);
+				output_write(out, node->str + node->literals[i].offset,
+							 node->literals[i].bytes);
+				output_char(out, '\n');
+			}
+			output_indent(out, indent);
+			output_str(out, "}\n");
+			break;
+
+		case n_array:
+			output_str(out, node->str ? "ARRAY[\n" : "[\n");
+			if (node->value)
+				debug_display_node(out, node->value, indent + 4);
+			output_indent(out, indent);
+			output_str(out, "]\n");
+			break;
+
+		case n_values:
+			output_str(out, "VALUES\n");
+			debug_display_node(out, node->value, indent + 4);
 			break;
 
 		case n_is_null:
 		case n_is_not_null:
-			fprintf(stderr, "%.*s\n", node->bytes, node->str);
-			debug_display_node(node->value, indent + 4);
+			output_write(out, node->str, node->bytes);
+			output_char(out, '\n');
+			debug_display_node(out, node->value, indent + 4);
 			break;
 
 		case n_expr:
 		case n_logical_and:
 		case n_logical_or:
 		case n_expr_wrapper:
-			fprintf(stderr, "%s", node->parenthesis ? "(" : "");
+			if (node->parenthesis)
+				output_char(out, '(');
 
 			if (node->type != n_expr_wrapper)
-				fprintf(stderr, "\"%.*s\"\n", node->bytes, node->str);
+			{
+				output_char(out, '"');
+				output_write(out, node->str, node->bytes);
+				output_str(out, "\"\n");
+			}
 			else
-				fprintf(stderr, "##>\n");
+				output_str(out, "##>\n");
 
-			debug_display_node(node->value, indent + 4);
+			if (node->type == n_logical_and || node->type == n_logical_or)
+			{
+				for (i = 0; i < node->nargs; i++)
+					debug_display_node(out, node->args[i], indent + 4);
+			}
+			else
+			{
+				Node   *op = node;
+				int		op_indent = indent;
 
-			if (node->type != n_expr_wrapper)
-				debug_display_node(node->other, indent + 4);
+				debug_display_node(out, node->value, indent + 4);
+
+				/* long chain of generic operators is displayed by loop */
+				while (is_operator_chain(op->other))
+				{
+					op = op->other;
+					op_indent += 4;
+
+					output_indent(out, op_indent);
+					output_char(out, '"');
+					output_write(out, op->str, op->bytes);
+					output_str(out, "\"\n");
+
+					debug_display_node(out, op->value, op_indent + 4);
+				}
+
+				/* EXISTS (subquery) has not second operand */
+				if (op->type != n_expr_wrapper && op->other)
+					debug_display_node(out, op->other, op_indent + 4);
+			}
 
 			if (node->asc)
-				fprintf(stderr, "%*sASC\n", indent, "");
+			{
+				output_indent(out, indent);
+				output_str(out, "ASC\n");
+			}
 			if (node->desc)
-				fprintf(stderr, "%*sDESC\n", indent, "");
+			{
+				output_indent(out, indent);
+				output_str(out, "DESC\n");
+			}
 			if (node->nulls_first)
-				fprintf(stderr, "%*sNULLS FIRST\n", indent, "");
+			{
+				output_indent(out, indent);
+				output_str(out, "NULLS FIRST\n");
+			}
 			if (node->nulls_last)
-				fprintf(stderr, "%*sNULLS LAST\n", indent, "");
+			{
+				output_indent(out, indent);
+				output_str(out, "NULLS LAST\n");
+			}
 			if (node->parenthesis)
-				fprintf(stderr, "%*s)\n", indent, "");
+			{
+				output_indent(out, indent);
+				output_str(out, ")\n");
+			}
 			break;
 
 		case n_query:
-			fprintf(stderr, "SELECT\n");
-			debug_display_node(node->columns, indent + 4);
+			/* rows of VALUES are displayed instead of SELECT list */
+			if (node->columns && node->columns->type == n_values)
+			{
+				output_str(out, "VALUES\n");
+				debug_display_node(out, node->columns->value, indent + 4);
+			}
+			else
+			{
+				output_str(out, "SELECT\n");
+				debug_display_node(out, node->columns, indent + 4);
+			}
 			if (node->from)
 			{
-				fprintf(stderr, "%*s%s", indent, "", "FROM\n");
-				debug_display_node(node->from, indent + 4);
+				output_indent(out, indent);
+				output_str(out, "FROM\n");
+				debug_display_node(out, node->from, indent + 4);
 			}
 			if (node->where)
 			{
-				fprintf(stderr, "%*s%s", indent, "", "WHERE\n");
-				debug_display_node(node->where, indent + 4);
+				output_indent(out, indent);
+				output_str(out, "WHERE\n");
+				debug_display_node(out, node->where, indent + 4);
 			}
 			if (node->group_by)
 			{
-				fprintf(stderr, "%*s%s", indent, "", "GROUP BY\n");
-				debug_display_node(node->group_by, indent + 4);
+				output_indent(out, indent);
+				output_str(out, "GROUP BY\n");
+				debug_display_node(out, node->group_by, indent + 4);
 			}
 			if (node->having)
 			{
-				fprintf(stderr, "%*s%s", indent, "", "HAVING\n");
-				debug_display_node(node->having, indent + 4);
+				output_indent(out, indent);
+				output_str(out, "HAVING\n");
+				debug_display_node(out, node->having, indent + 4);
 			}
 			if (node->order_by)
 			{
-				fprintf(stderr, "%*s%s", indent, "", "ORDER BY\n");
-				debug_display_node(node->order_by, indent + 4);
+				output_indent(out, indent);
+				output_str(out, "ORDER BY\n");
+				debug_display_node(out, node->order_by, indent + 4);
 			}
 			if (node->limit)
 			{
-				fprintf(stderr, "%*s%s", indent, "", "LIMIT\n");
-				debug_display_node(node->limit, indent + 4);
+				output_indent(out, indent);
+				output_str(out, "LIMIT\n");
+				debug_display_node(out, node->limit, indent + 4);
 			}
 			if (node->offset)
 			{
-				fprintf(stderr, "%*s%s", indent, "", "OFFSET\n");
-				debug_display_node(node->offset, indent + 4);
+				output_indent(out, indent);
+				output_str(out, "OFFSET\n");
+				debug_display_node(out, node->offset, indent + 4);
 			}
 			break;
 
 		case n_join:
 			if (node->relexpr_parenthesis)
 			{
-				fprintf(stderr, "(\n");
+				output_str(out, "(\n");
 				indent += 4;
-				fprintf(stderr, "%*s", indent, "");
+				output_indent(out, indent);
 			}
 
-			fprintf(stderr, "%s", node->is_natural ? "NATURAL " : "");
+			if (node->is_natural)
+				output_str(out, "NATURAL ");
 			switch (node->jointype)
 			{
 				case k_JOIN:
 				case k_INNER_JOIN:
-					fprintf(stderr, "INNER JOIN\n");
+					output_str(out, "INNER JOIN\n");
 					break;
 				case k_CROSS_JOIN:
-					fprintf(stderr, "CROSS JOIN\n");
+					output_str(out, "CROSS JOIN\n");
 					break;
 				case k_LEFT_OUTER_JOIN:
-					fprintf(stderr, "LEFT OUTER JOIN\n");
+					output_str(out, "LEFT OUTER JOIN\n");
 					break;
 				case k_RIGHT_OUTER_JOIN:
-					fprintf(stderr, "RIGHT OUTER JOIN\n");
+					output_str(out, "RIGHT OUTER JOIN\n");
 					break;
 				case k_FULL_OUTER_JOIN:
-					fprintf(stderr, "FULL OUTER JOIN\n");
+					output_str(out, "FULL OUTER JOIN\n");
+					break;
+				default:
 					break;
 			}
 
-			debug_display_node(node->left, indent + 4);
-			debug_display_node(node->right, indent + 4);
+			debug_display_node(out, node->left, indent + 4);
+			debug_display_node(out, node->right, indent + 4);
 
 			if (node->onexpr)
 			{
-				fprintf(stderr, "%*s%s", indent, "", "ON\n");
-				debug_display_node(node->onexpr, indent + 4);
+				output_indent(out, indent);
+				output_str(out, "ON\n");
+				debug_display_node(out, node->onexpr, indent + 4);
 			}
 			else if (node->using)
 			{
-				fprintf(stderr, "%*s%s", indent, "", "USING\n");
-				debug_display_node(node->using, indent + 4);
+				output_indent(out, indent);
+				output_str(out, "USING\n");
+				debug_display_node(out, node->using, indent + 4);
 			}
 
 			if (node->relexpr_parenthesis)
-				fprintf(stderr, "%*s%s", indent - 4, "", ")\n");
+			{
+				output_indent(out, indent - 4);
+				output_str(out, ")\n");
+			}
 			break;
 
 		default:
-			fprintf(stderr, "unknown type: %d\n", node->type);
+			output_printf(out, "unknown type: %d\n", node->type);
 	}
 }
@@ -1,74 +1,468 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include "pspretty.h"
 
 
-void
-out_of_memory()
+/*
+ * Input of parser. Regular files are mapped to memory, so the
+ * content is not copied before lexing.
+ */
+typedef struct
 {
-	fprintf(stderr, "out of memory\n");
-	exit(1);
-}
+	char   *str;
+	size_t	len;
+	bool	mapped;
+} InputData;
 
+/*
+ * Reads regular file of known size by one read. It is used when
+ * the file cannot be mapped.
+ */
 static char *
-readall(FILE *ifile)
+read_file(int fd, const char *name, size_t size, size_t *len)
 {
-	char   *buffer;
-	size_t	bufsize;
-	size_t	used;
-	size_t	readc;
-
-	used = 0;
-	bufsize = 10 * 1024;
-	buffer = malloc(bufsize);
+	char   *buffer = malloc(size + 1);
+	size_t	used = 0;
+
 	if (!buffer)
 		out_of_memory();
 
-	do
+	while (used < size)
 	{
-		if (bufsize - used < 1024)
-		{
-			if (bufsize < (1 * 1024 * 1024))
-				bufsize += bufsize;
-			else
-				bufsize += 1 * 1024 * 1024; /* 1MB */
-
-			buffer = realloc(buffer, bufsize);
-			if (!buffer)
-				out_of_memory();
-		}
-
-		readc = fread(buffer + used, 1, bufsize - used, ifile);
+		ssize_t		readc = read(fd, buffer + used, size - used);
 
-		if (ferror(ifile))
+		if (readc < 0)
 		{
-			fprintf(stderr, "cannot read\n");
+			if (errno == EINTR)
+				continue;
+
+			fprintf(stderr, "cannot read \"%s\": %s\n", name, strerror(errno));
 			exit(1);
 		}
 
+		/* file was truncated */
+		if (readc == 0)
+			break;
+
 		used += readc;
 	}
-	while (readc > 0);
 
 	buffer[used] = '\0';
+	*len = used;
 
 	return buffer;
 }
 
+/*
+ * Returns false, when the input is not regular file (pipe, terminal),
+ * and it should be processed as stream.
+ */
+static bool
+load_input(int fd, const char *name, InputData *input)
+{
+	struct stat st;
+
+	input->mapped = false;
+
+	if (fstat(fd, &st) < 0)
+	{
+		fprintf(stderr, "cannot stat \"%s\": %s\n", name, strerror(errno));
+		exit(1);
+	}
+
+	if (!S_ISREG(st.st_mode))
+		return false;
+
+	input->len = (size_t) st.st_size;
+
+	if (input->len == 0)
+	{
+		input->str = read_file(fd, name, 0, &input->len);
+		return true;
+	}
+
+	input->str = mmap(NULL, input->len, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (input->str != MAP_FAILED)
+	{
+		input->mapped = true;
+		madvise(input->str, input->len, MADV_SEQUENTIAL);
+		return true;
+	}
+
+	input->str = read_file(fd, name, input->len, &input->len);
+
+	return true;
+}
+
+static void
+release_input(InputData *input)
+{
+	if (input->mapped)
+		munmap(input->str, input->len);
+	else
+		free(input->str);
+}
+
+/*
+ * State of pspretty
+ */
+typedef struct
+{
+	PsParser	ps;
+	PsOutput	out;
+	PsBatch		batch;
+	bool		parallel;		/* statements are processed by batch */
+	bool		tree;			/* display parser tree instead of SQL */
+	PsFormatOptions format;
+	PsStats	   *stats;			/* NULL, when --stats is not used */
+	PsStats		stats_data;
+} Context;
+
+/*
+ * Writes formatted statement or parser tree. It can be called by
+ * workers of batch, so it should not to change context.
+ */
+static void
+display_node(Context *ctx, PsParser *ps, Node *node, PsOutput *out)
+{
+	double	start = 0.0;
+
+	if (ps->stats)
+		start = stats_time();
+
+	if (ctx->tree)
+		debug_display_node(out, node, 0);
+	else if (node)
+		format_statement(out, node, &ctx->format);
+	else
+	{
+		char   *str;
+		size_t	len;
+
+		/* statement with syntax error is written without changes */
+		get_statement_text(ps, &str, &len);
+		output_write(out, str, len);
+		output_char(out, '\n');
+	}
+
+	if (ps->stats)
+		ps->stats->output_time += stats_time() - start;
+}
+
+/*
+ * Input can contain more statements. Every statement is parsed and
+ * displayed separately.
+ */
+static void
+process_input(Context *ctx, InputData *input)
+{
+	Node   *node;
+	bool	error;
+
+	init_lexer(&ctx->ps, input->str, input->len, false);
+
+	while ((node = parse_next_statement(&ctx->ps, &error)) || error)
+		display_node(ctx, &ctx->ps, node, &ctx->out);
+}
+
+static void
+display_statement(PsParser *ps, Node *node, void *arg)
+{
+	Context	   *ctx = arg;
+
+	display_node(ctx, ps, node, &ctx->out);
+}
+
+static void
+display_batch_statement(PsParser *ps, Node *node, PsOutput *out, void *arg)
+{
+	display_node((Context *) arg, ps, node, out);
+}
+
+static void
+batch_statement(const char *str, size_t len,
+				int lineno, int pos,
+				bool stable, void *arg)
+{
+	batch_add((PsBatch *) arg, str, len, lineno, pos, stable);
+}
+
+static void
+init_context_feeder(Context *ctx, PsFeeder *feeder)
+{
+	if (ctx->parallel)
+		init_feeder_text(feeder, batch_statement, &ctx->batch);
+	else
+		init_feeder(feeder, &ctx->ps, false, display_statement, ctx);
+}
+
+/*
+ * Input of unknown size is read in chunks and passed to feeder, so
+ * only the last incomplete statement is held in memory.
+ */
+static void
+process_stream(Context *ctx, int fd, const char *name)
+{
+	PsFeeder feeder;
+	char	buffer[64 * 1024];
+
+	init_context_feeder(ctx, &feeder);
+
+	for (;;)
+	{
+		double		start = 0.0;
+		ssize_t		readc;
+
+		if (ctx->stats)
+			start = stats_time();
+
+		readc = read(fd, buffer, sizeof(buffer));
+
+		if (ctx->stats)
+			ctx->stats->read_time += stats_time() - start;
+
+		if (readc < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			fprintf(stderr, "cannot read \"%s\": %s\n", name, strerror(errno));
+			exit(1);
+		}
+
+		if (readc == 0)
+			break;
+
+		feed_input(&feeder, buffer, readc);
+	}
+
+	finish_feed(&feeder);
+	free_feeder(&feeder);
+}
+
+static void
+process_file(Context *ctx, int fd, const char *name)
+{
+	InputData input;
+	double	start = 0.0;
+	bool	loaded;
+
+	if (ctx->stats)
+		start = stats_time();
+
+	/* mapped file is read later, when it is lexed */
+	loaded = load_input(fd, name, &input);
+
+	if (ctx->stats)
+		ctx->stats->read_time += stats_time() - start;
+
+	if (loaded)
+	{
+		/*
+		 * Tokens holds 32bit offsets, so the lexer cannot process larger
+		 * file at once. Then the file is split to statements by feeder
+		 * like for parallel processing, and the limit is per statement.
+		 */
+		if (ctx->parallel || input.len > UINT32_MAX)
+		{
+			PsFeeder feeder;
+
+			/* statements are not copied, jobs points to input */
+			init_context_feeder(ctx, &feeder);
+			feed_whole_input(&feeder, input.str, input.len);
+			free_feeder(&feeder);
+
+			/* input should not be used after release */
+			if (ctx->parallel)
+				finish_batch(&ctx->batch);
+		}
+		else
+			process_input(ctx, &input);
+
+		release_input(&input);
+	}
+	else
+		process_stream(ctx, fd, name);
+}
+
+static void
+usage(const char *progname)
+{
+	fprintf(stderr, "Usage: %s [-j workers] [--tree] [--lower] [--width N] [--stats] [--max-depth N]\n"
+			"       [--max-nodes N] [--max-tokens N] [--timeout MS] [--mmap-nodes] [--huge-pages]\n"
+			"       [file ...]\n",
+			progname);
+	exit(1);
+}
 
 int
 main(int argc, char *argv[])
 {
-	char   *str;
-	Node   *node;
+	Context	ctx;
+	bool	error;
+	int		nworkers = 1;
+	int		max_depth = PS_DEFAULT_MAX_DEPTH;
+	bool	mmap_nodes = false;
+	bool	huge_pages = false;
+	PsBudget budget;
+	int		c;
+	int		i;
+
+	static struct option long_options[] = {
+		{"tree", no_argument, NULL, 't'},
+		{"lower", no_argument, NULL, 'l'},
+		{"width", required_argument, NULL, 'w'},
+		{"stats", no_argument, NULL, 's'},
+		{"max-depth", required_argument, NULL, 'd'},
+		{"max-nodes", required_argument, NULL, 'n'},
+		{"max-tokens", required_argument, NULL, 'k'},
+		{"timeout", required_argument, NULL, 'o'},
+		{"mmap-nodes", no_argument, NULL, 'm'},
+		{"huge-pages", no_argument, NULL, 'p'},
+		{NULL, 0, NULL, 0}
+	};
+
+	memset(&ctx, 0, sizeof(Context));
+	memset(&budget, 0, sizeof(PsBudget));
+	init_format_options(&ctx.format);
+
+	while ((c = getopt_long(argc, argv, "j:", long_options, NULL)) != -1)
+	{
+		switch (c)
+		{
+			case 't':
+				ctx.tree = true;
+				break;
+
+			case 'l':
+				ctx.format.keyword_case = kc_lower;
+				break;
 
-	str = readall(stdin);
+			case 's':
+				ctx.stats = &ctx.stats_data;
+				init_stats(ctx.stats);
+				break;
 
-	node = parser(str, false);
+			case 'w':
+				ctx.format.line_width = atoi(optarg);
+				if (ctx.format.line_width < 1)
+					usage(argv[0]);
+				break;
 
-	debug_display_node(node, 0);
+			case 'd':
+				max_depth = atoi(optarg);
+				if (max_depth < 1)
+					usage(argv[0]);
+				break;
+
+			case 'n':
+				budget.max_nodes = atoll(optarg);
+				if (budget.max_nodes < 1)
+					usage(argv[0]);
+				break;
+
+			case 'k':
+				budget.max_tokens = atoll(optarg);
+				if (budget.max_tokens < 1)
+					usage(argv[0]);
+				break;
+
+			case 'o':
+				budget.timeout = atoi(optarg);
+				if (budget.timeout < 1)
+					usage(argv[0]);
+				break;
+
+			case 'm':
+				mmap_nodes = true;
+				break;
+
+			case 'p':
+				/* huge pages are used only for mapped blocks */
+				mmap_nodes = true;
+				huge_pages = true;
+				break;
+
+			case 'j':
+				nworkers = atoi(optarg);
+				if (nworkers < 1)
+					usage(argv[0]);
+				break;
+
+			default:
+				usage(argv[0]);
+		}
+	}
+
+	init_psparser(&ctx.ps);
+	ctx.ps.token_array = true;
+	ctx.ps.stats = ctx.stats;
+	ctx.ps.max_depth = max_depth;
+	ctx.ps.mmap_nodes = mmap_nodes;
+	ctx.ps.huge_pages = huge_pages;
+	ctx.ps.budget = budget;
+
+	init_output_fd(&ctx.out, STDOUT_FILENO);
+
+	if (nworkers > 1)
+	{
+		ctx.parallel = init_batch(&ctx.batch, nworkers, &ctx.out, false,
+								  display_batch_statement, &ctx);
+		if (!ctx.parallel)
+			fprintf(stderr, "cannot create worker threads, statements are processed serially\n");
+	}
+
+	if (ctx.parallel)
+	{
+		ctx.batch.stats = ctx.stats;
+		ctx.batch.max_depth = max_depth;
+		ctx.batch.mmap_nodes = mmap_nodes;
+		ctx.batch.huge_pages = huge_pages;
+		ctx.batch.budget = budget;
+	}
+
+	if (optind >= argc)
+		process_file(&ctx, STDIN_FILENO, "stdin");
+
+	for (i = optind; i < argc; i++)
+	{
+		int		fd = open(argv[i], O_RDONLY);
+
+		if (fd < 0)
+		{
+			fprintf(stderr, "cannot open \"%s\": %s\n", argv[i], strerror(errno));
+			exit(1);
+		}
+
+		process_file(&ctx, fd, argv[i]);
+		close(fd);
+	}
+
+	if (ctx.parallel)
+		free_batch(&ctx.batch);
+
+	output_flush(&ctx.out);
+	error = ctx.out.error;
+
+	free_output(&ctx.out);
+	free_psparser(&ctx.ps);
+
+	if (ctx.stats)
+	{
+		PsOutput	out;
+
+		init_output_fd(&out, STDERR_FILENO);
+		display_stats(&out, ctx.stats);
+		free_output(&out);
+	}
 
-	return 0;
+	return error ? 1 : 0;
 }
@@ -2,7 +2,13 @@
 
 #define PSPRETTY_H
 
+#include <pthread.h>
+#include <setjmp.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "libpspretty.h"
 
 typedef enum
 {
@@ -27,26 +33,30 @@ typedef enum
 } TokenType;
 
 
+/*
+ * Tokens are stored in arrays, so they should be small. Token holds
+ * only offset of first char from start of input (see TOKEN_STR).
+ */
 typedef struct
 {
-	TokenType type;
-	int		lineno;			/* line number from start document */
-	char   *line;			/* ptr to line where this token starts */
-	int		pos;			/* position from start of line */
-	char   *str;			/* pointr to first char of token */
-	int		bytes;			/* how much bytes */
-	int		value;			/* value of char type token or keyword token */
-	bool	quoted;			/* true, when identifier is quoted */
-	bool	escaped;		/* true, when string is scaped */
-	bool	singleline;		/* true, when comment is singleline */
-	bool	reserved;		/* keywords that cannot be used inside expression */
-	bool	natural_join;	/* is natural JOIN */
-	bool	comparing_op;	/* true, when operator is =, <>, <, >, <= or >= */
+	uint32_t offset;		/* offset of first char of token */
+	uint32_t bytes;			/* how much bytes */
+	int16_t	value;			/* value of char type token or keyword token */
+	int8_t	type;			/* TokenType */
+	bool	quoted:1;		/* true, when identifier is quoted */
+	bool	escaped:1;		/* true, when string is scaped */
+	bool	singleline:1;	/* true, when comment is singleline */
+	bool	reserved:1;		/* keywords that cannot be used inside expression */
+	bool	natural_join:1;	/* is natural JOIN */
+	bool	comparing_op:1;	/* true, when operator is =, <>, <, >, <= or >= */
 } Token;
 
+_Static_assert(sizeof(Token) <= 16, "Token should be 16 bytes or less");
+
 typedef enum
 {
 	k_AND = 256,
+	k_ARRAY,
 	k_AS,
 	k_ASC,
 	k_BETWEEN,
@@ -127,7 +137,10 @@ typedef enum
 	n_query,
 	n_composite,
 	n_is,
-	n_join
+	n_join,
+	n_literal_array,
+	n_array,
+	n_values
 } NodeType;
 
 typedef enum
@@ -135,12 +148,28 @@ typedef enum
 	expr_generic,
 	expr_like,
 	expr_ilike,
-	expr_between
+	expr_between,
+	expr_in,
+	expr_not_in
 } SpecialExprType;
 
+/*
+ * Item of literal array. The lists of constants (IN lists, rows of
+ * VALUES, ARRAY[]) are stored packed, without nodes for every item.
+ */
+typedef struct
+{
+	uint32_t offset;		/* offset of first char from str of array node */
+	uint32_t bytes;
+	uint8_t	type;			/* NodeType of literal (n_numeric, n_string, ...) */
+} Literal;
+
+_Static_assert(sizeof(Literal) <= 12, "Literal should be 12 bytes or less");
+
 typedef struct _node
 {
 	NodeType	type;
+	int			width;			/* width on one line, set by formatter */
 	union {
 		struct {
 			struct _node *value;
@@ -149,12 +178,18 @@ typedef struct _node
 			int		bytes;
 			bool	negative;		/* - expr */
 			bool	negate;			/* NOT expr */
+			bool	is_not;			/* expr IS NOT TRUE */
 			bool	parenthesis;	/* (expr) */
 			bool	desc;			/* ORDER BY DESC */
 			bool	asc;			/* ORDER BY ASC */
 			bool	nulls_first;	/* ORDER BY NULLS FIRST */
 			bool	nulls_last;		/* ORDER BY NULLS LAST */
 			SpecialExprType exprtype;
+			union {
+				struct _node **args;	/* operands of AND, OR */
+				Literal *literals;		/* items of literal array */
+			};
+			int		nargs;			/* number of args or literals */
 		};
 		struct {
 			struct _node *columns;
@@ -183,18 +218,346 @@ typedef struct _nodeAllocator
 	Node	   *nodes;
 	int			size;
 	int			used;
+	size_t		mapped;			/* size of mapping, 0 when block is malloced */
 	struct _nodeAllocator *next;
 } NodeAllocator;
 
-extern void init_lexer(char *str, bool _force8bit);
-extern Token *next_token(Token *token);
-extern void push_token(Token *token);
-extern void debug_print_token(Token *token);
-extern void push_token_debug(Token *token, char *str);
+typedef struct
+{
+	NodeAllocator *block;
+	int			used;
+} NodeAllocatorMark;
+
+/* tt_EOF is -1, so token counts are indexed by type + 1 */
+#define PS_TOKEN_TYPES		(tt_semicolon + 2)
+#define PS_NODE_TYPES		(n_values + 1)
+
+/*
+ * Default limit of depth of recursion of parser. One level of nested
+ * subquery needs few levels of depth, and the stack used by this depth
+ * is less than 1MB.
+ */
+#define PS_DEFAULT_MAX_DEPTH	1000
+
+/*
+ * Budgets of one statement, zero is unlimited. When some budget is
+ * exceeded, the statement fails, and the parsing continues by next
+ * statement. The deadline is checked every PS_DEADLINE_CHECK_TOKENS
+ * tokens, so the check of time is cheap.
+ */
+typedef struct
+{
+	int64_t		max_nodes;				/* allocated node slots */
+	int64_t		max_tokens;
+	int			timeout;				/* time of lexing and parsing in ms */
+} PsBudget;
+
+#define PS_DEADLINE_CHECK_TOKENS	1024
+
+/*
+ * Statistics of lexer, parser and node allocator. They are collected
+ * only when stats of parser context is not NULL.
+ */
+typedef struct
+{
+	/* wall time of phases in seconds */
+	double		read_time;
+	double		lex_time;
+	double		parse_time;
+	double		output_time;
+
+	int64_t		statements;
+	int64_t		tokens[PS_TOKEN_TYPES];
+	int64_t		next_token_calls;
+	int64_t		push_token_calls;
+	int			max_depth;				/* max depth of recursion of parser */
+	int64_t		nodes[PS_NODE_TYPES];
+
+	int64_t		allocator_blocks;
+	int64_t		allocator_bytes;
+	int64_t		nodes_high_water;		/* max of nodes used at once */
+} PsStats;
+
+typedef enum
+{
+	po_buffer,
+	po_fd,
+	po_callback
+} PsOutputType;
+
+typedef void (*PsOutputCallback) (const char *data, size_t len, void *arg);
+
+/*
+ * Output sink used by all printers. The data are buffered, and
+ * written to fd or passed to callback in large chunks.
+ */
+typedef struct
+{
+	PsOutputType type;
+	char	   *data;
+	size_t		size;
+	size_t		used;
+	int			fd;
+	PsOutputCallback callback;
+	void	   *callback_arg;
+	bool		error;			/* write to fd failed */
+} PsOutput;
+
+/*
+ * Holds all state of lexer and parser. There are not any global
+ * variables, so more parsers can be used in one process (thread
+ * per parser).
+ */
+typedef struct
+{
+	char   *istr, *_istr, *STR;		/* STR is ptr to last read char */
+	char   *iend;					/* ptr after last char of input */
+
+	bool	after_eof;				/* last sgetc returned EOF */
+	bool	force8bit;
+
+	/* offsets of starts of lines, it is built when it is necessary */
+	uint32_t *line_starts;
+	int		line_starts_size;
+	int		nlines;					/* -1 when index is not built yet */
+
+	/* position of input in stream, when input is part of stream */
+	int		line_offset;
+	int		pos_offset;
+
+	/* tokens pushed back by parser, when token array is not used */
+	Token	tokenbuf[10];
+	int		tokenidx;
+
+	/* lexed tokens, that are not consumed yet (multiverb lookahead) */
+	Token	lookahead[4];
+	int		nlookahead;
+
+	/* tokens of input, when input was tokenized before parsing */
+	bool	token_array;			/* parser() should to use token array */
+	bool	tokens_ready;			/* next_token reads from token array */
+	Token  *tokens;
+	int		ntokens;
+	int		tokens_size;
+	int		tokencur;
+	uint32_t tokens_start;			/* offset of input, where tokenize started */
+
+	/* node blocks are allocated by mmap, optionally on huge pages */
+	bool	mmap_nodes;
+	bool	huge_pages;
+	NodeAllocator *root_allocator;
+	NodeAllocator *current_allocator;
+
+	int		depth;					/* current depth of recursion of parser */
+	int		max_depth;				/* parsing fails, when depth is higher */
+
+	/* budgets of statement, and their state for current statement */
+	PsBudget budget;
+	int64_t	statement_nodes;
+	int64_t	statement_tokens;
+	double	deadline;				/* zero, when there is not timeout */
+	jmp_buf *budget_jmp;			/* NULL, when budgets are not checked */
+
+	/* stack of operands of AND, OR chains, that are parsed */
+	Node  **operands;
+	int		noperands;
+	int		operands_size;
+	PsStats *stats;					/* NULL, when stats are not collected */
+
+	/* first error of last statement */
+	PsErrorCode error_code;
+	char	errmsg[256];
+	bool	quiet;					/* errors are not printed to stderr */
+	PsOutput *errout;				/* errors are written here too, when not NULL */
+
+	/* when it is not NULL, then fatal errors jump there, else exit */
+	jmp_buf *error_jmp;
+} PsParser;
+
+typedef enum
+{
+	kc_upper,
+	kc_lower
+} KeywordCase;
+
+typedef struct
+{
+	KeywordCase keyword_case;
+	int			indent_width;
+	int			line_width;		/* longer lines are broken */
+} PsFormatOptions;
+
+typedef void (*PsStatementCallback) (PsParser *ps, Node *node, void *arg);
+
+/*
+ * Receives text of statements (without parsing). The text is valid only
+ * inside callback, when stable is false. lineno and pos are position of
+ * text in stream.
+ */
+typedef void (*PsTextCallback) (const char *str, size_t len,
+								int lineno, int pos,
+								bool stable, void *arg);
+
+/*
+ * State of push style API. The input is passed in chunks, and only
+ * the last incomplete statement is held in buffer.
+ */
+typedef struct
+{
+	PsParser   *ps;
+	bool		force8bit;
+	PsStatementCallback callback;
+	PsTextCallback text_callback;	/* used instead of parser, when it is set */
+	void	   *callback_arg;
+
+	char	   *buffer;
+	bool		stable;			/* buffer is input passed by feed_whole_input */
+	size_t		size;
+	size_t		used;
+	size_t		start;			/* start of current statement */
+	size_t		scanned;		/* bytes processed by statement splitter */
+	int			state;			/* state of statement splitter */
+
+	int			lineno;			/* number of new lines before scanned */
+	long long	line_start;		/* start of last line, can be before buffer */
+	int			start_lineno;	/* position of current statement */
+	int			start_pos;
+} PsFeeder;
+
+/*
+ * Called by worker of batch for every parsed statement (node is NULL
+ * after syntax error). The result should be written to out.
+ */
+typedef void (*PsBatchCallback) (PsParser *ps, Node *node, PsOutput *out, void *arg);
+
+/*
+ * Statements processed by one worker of batch, and its output
+ */
+typedef struct
+{
+	char	   *str;
+	size_t		len;
+	int			lineno;			/* position of text in stream */
+	int			pos;
+	bool		stable;			/* str points to input, not to buffer */
+	char	   *buffer;			/* copy of not stable text */
+	size_t		size;
+	PsOutput	out;
+	PsOutput	err;			/* error messages of statements */
+	bool		done;
+} BatchJob;
+
+/*
+ * Pool of worker threads. Jobs are in ring buffer, next_write <=
+ * next_dispatch <= next_seq are sequence numbers of jobs.
+ */
+typedef struct
+{
+	PsOutput   *out;
+	bool		force8bit;
+	PsBatchCallback callback;
+	void	   *callback_arg;
+
+	pthread_t  *workers;
+	int			nworkers;
+
+	BatchJob   *jobs;
+	int			njobs;
+	bool		pending;		/* job next_seq is being filled */
+	uint64_t	next_seq;		/* next submitted job */
+	uint64_t	next_dispatch;	/* next job for worker */
+	uint64_t	next_write;		/* next job for writing */
+	bool		shutdown;
+
+	/* stats of workers are added here, can be set before first batch_add */
+	PsStats	   *stats;
+
+	/* max_depth of parsers of workers, can be set before first batch_add */
+	int			max_depth;
+
+	/* node blocks of workers are mapped, can be set before first batch_add */
+	bool		mmap_nodes;
+	bool		huge_pages;
+
+	/* budgets of statements, can be set before first batch_add */
+	PsBudget	budget;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t job_ready;
+	pthread_cond_t job_done;
+} PsBatch;
+
+#define TOKEN_STR(ps, token)		((ps)->istr + (token)->offset)
+
+extern void init_lexer(PsParser *ps, char *str, size_t len, bool _force8bit);
+extern Token *next_token(PsParser *ps, Token *token);
+extern void push_token(PsParser *ps, Token *token);
+extern void get_token_position(PsParser *ps, Token *token, int *lineno, uint32_t *pos);
+extern bool tokenize(PsParser *ps);
+extern bool tokenize_statement(PsParser *ps);
+extern void skip_statement(PsParser *ps);
+extern const char *token_type_name(TokenType type);
+extern void debug_print_token(PsParser *ps, Token *token);
+extern void push_token_debug(PsParser *ps, Token *token, char *str);
+
+extern void init_psparser(PsParser *ps);
+extern void free_psparser(PsParser *ps);
+extern Node *parser(PsParser *ps, char *str, size_t len, bool force8bit);
+extern Node *parse_next_statement(PsParser *ps, bool *error);
+extern void get_statement_text(PsParser *ps, char **str, size_t *len);
+extern Node *parse_query(PsParser *ps);
+extern void out_of_memory(void);
+extern void parser_error(PsParser *ps, PsErrorCode code, const char *fmt, ...)
+	__attribute__((format(printf, 3, 4)));
+extern void parser_fatal(PsParser *ps, PsErrorCode code, const char *fmt, ...)
+	__attribute__((format(printf, 3, 4), noreturn));
+extern void budget_exceeded(PsParser *ps, PsErrorCode code, const char *fmt, ...)
+	__attribute__((format(printf, 3, 4), noreturn));
+extern void reset_parser_error(PsParser *ps);
+extern void set_error_context(PsParser *ps);
+
+extern void reset_node_allocator(PsParser *ps);
+extern void free_node_allocator(PsParser *ps);
+extern NodeAllocatorMark mark_node_allocator(PsParser *ps);
+extern void release_node_allocator(PsParser *ps, NodeAllocatorMark mark);
+
+extern void debug_display_node(PsOutput *out, Node *node, int indent);
+extern const char *node_type_name(NodeType type);
+extern bool is_operator_chain(Node *node);
+extern void update_allocator_stats(PsParser *ps);
+
+extern void init_feeder(PsFeeder *f, PsParser *ps, bool force8bit,
+						PsStatementCallback callback, void *callback_arg);
+extern void init_feeder_text(PsFeeder *f, PsTextCallback callback, void *callback_arg);
+extern void feed_input(PsFeeder *f, const char *data, size_t len);
+extern void feed_whole_input(PsFeeder *f, const char *str, size_t len);
+extern void finish_feed(PsFeeder *f);
+extern void free_feeder(PsFeeder *f);
+
+extern bool init_batch(PsBatch *b, int nworkers, PsOutput *out, bool force8bit,
+					   PsBatchCallback callback, void *callback_arg);
+extern void batch_add(PsBatch *b, const char *str, size_t len,
+					  int lineno, int pos, bool stable);
+extern void finish_batch(PsBatch *b);
+extern void free_batch(PsBatch *b);
+
+extern void init_format_options(PsFormatOptions *opts);
+extern void format_statement(PsOutput *out, Node *node, PsFormatOptions *opts);
 
-extern Node *parser(char *str, bool force8bit);
-extern void out_of_memory();
+extern void init_stats(PsStats *stats);
+extern double stats_time(void);
+extern void merge_stats(PsStats *dest, PsStats *src);
+extern void display_stats(PsOutput *out, PsStats *stats);
 
-extern void debug_display_node(Node *node, int indent);
+extern void init_output_buffer(PsOutput *out);
+extern void init_output_fd(PsOutput *out, int fd);
+extern void init_output_callback(PsOutput *out, PsOutputCallback callback, void *arg);
+extern void output_write(PsOutput *out, const char *str, size_t len);
+extern void output_str(PsOutput *out, const char *str);
+extern void output_char(PsOutput *out, char c);
+extern void output_indent(PsOutput *out, int n);
+extern void output_printf(PsOutput *out, const char *fmt, ...);
+extern void output_flush(PsOutput *out);
+extern void free_output(PsOutput *out);
 
 #endif
@@ -0,0 +1,115 @@
+#include <string.h>
+#include <time.h>
+
+#include "pspretty.h"
+
+/*
+ * Statistics of lexer, parser and node allocator. The counters are
+ * incremented by lexer and parser, when the context has stats. The
+ * stats of more contexts (workers of batch) can be merged.
+ */
+
+void
+init_stats(PsStats *stats)
+{
+	memset(stats, 0, sizeof(PsStats));
+}
+
+/*
+ * Returns wall time in seconds, used for time of phases
+ */
+double
+stats_time(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Adds stats of src to dest. The times are summed, so with more
+ * workers they are higher than elapsed time. The maximums are not
+ * summed.
+ */
+void
+merge_stats(PsStats *dest, PsStats *src)
+{
+	int		i;
+
+	dest->read_time += src->read_time;
+	dest->lex_time += src->lex_time;
+	dest->parse_time += src->parse_time;
+	dest->output_time += src->output_time;
+
+	dest->statements += src->statements;
+
+	for (i = 0; i < PS_TOKEN_TYPES; i++)
+		dest->tokens[i] += src->tokens[i];
+
+	dest->next_token_calls += src->next_token_calls;
+	dest->push_token_calls += src->push_token_calls;
+
+	if (src->max_depth > dest->max_depth)
+		dest->max_depth = src->max_depth;
+
+	for (i = 0; i < PS_NODE_TYPES; i++)
+		dest->nodes[i] += src->nodes[i];
+
+	dest->allocator_blocks += src->allocator_blocks;
+	dest->allocator_bytes += src->allocator_bytes;
+
+	if (src->nodes_high_water > dest->nodes_high_water)
+		dest->nodes_high_water = src->nodes_high_water;
+}
+
+void
+display_stats(PsOutput *out, PsStats *stats)
+{
+	int64_t		total;
+	int			i;
+
+	output_printf(out, "statements: %lld\n", (long long) stats->statements);
+
+	output_printf(out, "time: read %.3f s, lex %.3f s, parse %.3f s, output %.3f s\n",
+				  stats->read_time, stats->lex_time,
+				  stats->parse_time, stats->output_time);
+
+	total = 0;
+	for (i = 0; i < PS_TOKEN_TYPES; i++)
+		total += stats->tokens[i];
+
+	output_printf(out, "tokens: %lld\n", (long long) total);
+
+	for (i = 0; i < PS_TOKEN_TYPES; i++)
+	{
+		if (stats->tokens[i] > 0)
+			output_printf(out, "    %-16s %lld\n",
+						  token_type_name(i - 1), (long long) stats->tokens[i]);
+	}
+
+	output_printf(out, "next_token calls: %lld, push_token calls: %lld\n",
+				  (long long) stats->next_token_calls,
+				  (long long) stats->push_token_calls);
+
+	output_printf(out, "max depth: %d\n", stats->max_depth);
+
+	total = 0;
+	for (i = 0; i < PS_NODE_TYPES; i++)
+		total += stats->nodes[i];
+
+	output_printf(out, "nodes: %lld\n", (long long) total);
+
+	for (i = 0; i < PS_NODE_TYPES; i++)
+	{
+		if (stats->nodes[i] > 0)
+			output_printf(out, "    %-16s %lld\n",
+						  node_type_name(i), (long long) stats->nodes[i]);
+	}
+
+	output_printf(out, "node allocator: %lld blocks, %lld bytes, high-water %lld nodes\n",
+				  (long long) stats->allocator_blocks,
+				  (long long) stats->allocator_bytes,
+				  (long long) stats->nodes_high_water);
+}
@@ -0,0 +1,84 @@
+#!/bin/sh
+#
+# Regression tests of pspretty CLI, used by make check.
+#
+# Every tests/sql/NAME.sql is formatted from file by one process, and
+# stdout and stderr are compared with tests/expected/NAME.out. The
+# options are read from tests/sql/NAME.opts, when it exists.
+#
+# The same input is formatted from pipe and by more workers too. These
+# paths split statements by the statement splitter (feed.c) instead of
+# the lexer, so their output and error messages should be same as
+# output of first run.
+#
+# Usage: tests/run_tests.sh [pspretty]
+#
+
+PSPRETTY=${1:-./pspretty}
+TESTDIR=$(dirname "$0")
+TMPDIR=${TMPDIR:-/tmp}
+RESULT="$TMPDIR/pspretty_test.$$"
+
+failed=0
+total=0
+
+trap 'rm -f "$RESULT".*' EXIT
+
+# compares result ($3) with expected file ($2), prints diff when they are different
+check_result()
+{
+	total=$((total + 1))
+
+	if cmp -s "$2" "$3"; then
+		echo "ok      $1"
+	else
+		echo "FAILED  $1"
+		diff -u "$2" "$3" | head -40
+		failed=$((failed + 1))
+	fi
+}
+
+for sql in "$TESTDIR"/sql/*.sql; do
+	name=$(basename "$sql" .sql)
+	expected="$TESTDIR/expected/$name.out"
+	opts=""
+
+	if [ -f "$TESTDIR/sql/$name.opts" ]; then
+		opts=$(cat "$TESTDIR/sql/$name.opts")
+	fi
+
+	$PSPRETTY $opts "$sql" > "$RESULT.out" 2> "$RESULT.err"
+	cat "$RESULT.out" "$RESULT.err" > "$RESULT.all"
+	check_result "$name" "$expected" "$RESULT.all"
+
+	cat "$sql" | $PSPRETTY $opts > "$RESULT.out" 2> "$RESULT.err"
+	cat "$RESULT.out" "$RESULT.err" > "$RESULT.pipe"
+	check_result "$name (pipe)" "$RESULT.all" "$RESULT.pipe"
+
+	$PSPRETTY $opts -j 2 "$sql" > "$RESULT.out" 2> "$RESULT.err"
+	cat "$RESULT.out" "$RESULT.err" > "$RESULT.par"
+	check_result "$name (-j 2)" "$RESULT.all" "$RESULT.par"
+
+	cat "$sql" | $PSPRETTY $opts -j 2 > "$RESULT.out" 2> "$RESULT.err"
+	cat "$RESULT.out" "$RESULT.err" > "$RESULT.par"
+	check_result "$name (pipe, -j 2)" "$RESULT.all" "$RESULT.par"
+done
+
+# Larger input is processed by more jobs, and the error messages of
+# jobs should be written in same order like by serial processing.
+i=0
+while [ $i -lt 500 ]; do
+	cat "$TESTDIR/sql/errors.sql" "$TESTDIR/sql/select.sql"
+	i=$((i + 1))
+done > "$RESULT.sql"
+
+$PSPRETTY "$RESULT.sql" > "$RESULT.out" 2> "$RESULT.err"
+cat "$RESULT.out" "$RESULT.err" > "$RESULT.all"
+
+$PSPRETTY -j 4 "$RESULT.sql" > "$RESULT.out" 2> "$RESULT.err"
+cat "$RESULT.out" "$RESULT.err" > "$RESULT.par"
+check_result "more jobs (-j 4)" "$RESULT.all" "$RESULT.par"
+
+echo "$((total - failed)) of $total tests passed"
+
+[ $failed -eq 0 ]
@@ -0,0 +1,7 @@
+select a, from t;
+select 1;
+select a from t where a = ;
+select (( ) from t;
+select 2;
+select a from t where x in 1;
+select 'unclosed
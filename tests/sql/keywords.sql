@@ -0,0 +1,7 @@
+select a from t where not not not not not not not not not not not a;
+select a from t where a is not null and b is null and c not in (1, 2) and not d;
+select a from t natural left outer join u natural full join v;
+select a from t left join s on true left outer join u on true right join v on true;
+select a from t group by a order by a nulls first, b nulls last;
+select group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group group a;
+select 1;
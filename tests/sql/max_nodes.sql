@@ -0,0 +1,4 @@
+select a, b, c from t where a = 1 and b in (1, 2, 3);
+select a from t;
+select a, b, c, d, e, f, g, h, i, j, k, l;
+select 1;
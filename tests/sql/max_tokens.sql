@@ -0,0 +1,4 @@
+select a, b; select c; select d;
+select a, group by x;
+select e;
+select f, g, h
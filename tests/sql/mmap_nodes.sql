@@ -0,0 +1,2 @@
+select a0 + b * 0, a1 + b * 1, a2 + b * 2, a3 + b * 3, a4 + b * 4, a5 + b * 5, a6 + b * 6, a7 + b * 7, a8 + b * 8, a9 + b * 9, a10 + b * 10, a11 + b * 11, a12 + b * 12, a13 + b * 13, a14 + b * 14, a15 + b * 15, a16 + b * 16, a17 + b * 17, a18 + b * 18, a19 + b * 19, a20 + b * 20, a21 + b * 21, a22 + b * 22, a23 + b * 23, a24 + b * 24, a25 + b * 25, a26 + b * 26, a27 + b * 27, a28 + b * 28, a29 + b * 29, a30 + b * 30, a31 + b * 31, a32 + b * 32, a33 + b * 33, a34 + b * 34, a35 + b * 35, a36 + b * 36, a37 + b * 37, a38 + b * 38, a39 + b * 39, a40 + b * 40, a41 + b * 41, a42 + b * 42, a43 + b * 43, a44 + b * 44, a45 + b * 45, a46 + b * 46, a47 + b * 47, a48 + b * 48, a49 + b * 49, a50 + b * 50, a51 + b * 51, a52 + b * 52, a53 + b * 53, a54 + b * 54, a55 + b * 55, a56 + b * 56, a57 + b * 57, a58 + b * 58, a59 + b * 59, a60 + b * 60, a61 + b * 61, a62 + b * 62, a63 + b * 63, a64 + b * 64, a65 + b * 65, a66 + b * 66, a67 + b * 67, a68 + b * 68, a69 + b * 69, a70 + b * 70, a71 + b * 71, a72 + b * 72, a73 + b * 73, a74 + b * 74, a75 + b * 75, a76 + b * 76, a77 + b * 77, a78 + b * 78, a79 + b * 79, a80 + b * 80, a81 + b * 81, a82 + b * 82, a83 + b * 83, a84 + b * 84, a85 + b * 85, a86 + b * 86, a87 + b * 87, a88 + b * 88, a89 + b * 89, a90 + b * 90, a91 + b * 91, a92 + b * 92, a93 + b * 93, a94 + b * 94, a95 + b * 95, a96 + b * 96, a97 + b * 97, a98 + b * 98, a99 + b * 99, a100 + b * 100, a101 + b * 101, a102 + b * 102, a103 + b * 103, a104 + b * 104, a105 + b * 105, a106 + b * 106, a107 + b * 107, a108 + b * 108, a109 + b * 109, a110 + b * 110, a111 + b * 111, a112 + b * 112, a113 + b * 113, a114 + b * 114, a115 + b * 115, a116 + b * 116, a117 + b * 117, a118 + b * 118, a119 + b * 119, a120 + b * 120, a121 + b * 121, a122 + b * 122, a123 + b * 123, a124 + b * 124, a125 + b * 125, a126 + b * 126, a127 + b * 127, a128 + b * 128, a129 + b * 129, a130 + b * 130, a131 + b * 131, a132 + b * 132, a133 + b * 133, a134 + b * 134, a135 + b * 135, a136 + b * 136, a137 + b * 137, a138 + b * 138, a139 + b * 139, a140 + b * 140, a141 + b * 141, a142 + b * 142, a143 + b * 143, a144 + b * 144, a145 + b * 145, a146 + b * 146, a147 + b * 147, a148 + b * 148, a149 + b * 149, a150 + b * 150, a151 + b * 151, a152 + b * 152, a153 + b * 153, a154 + b * 154, a155 + b * 155, a156 + b * 156, a157 + b * 157, a158 + b * 158, a159 + b * 159, a160 + b * 160, a161 + b * 161, a162 + b * 162, a163 + b * 163, a164 + b * 164, a165 + b * 165, a166 + b * 166, a167 + b * 167, a168 + b * 168, a169 + b * 169, a170 + b * 170, a171 + b * 171, a172 + b * 172, a173 + b * 173, a174 + b * 174, a175 + b * 175, a176 + b * 176, a177 + b * 177, a178 + b * 178, a179 + b * 179, a180 + b * 180, a181 + b * 181, a182 + b * 182, a183 + b * 183, a184 + b * 184, a185 + b * 185, a186 + b * 186, a187 + b * 187, a188 + b * 188, a189 + b * 189, a190 + b * 190, a191 + b * 191, a192 + b * 192, a193 + b * 193, a194 + b * 194, a195 + b * 195, a196 + b * 196, a197 + b * 197, a198 + b * 198, a199 + b * 199, a200 + b * 200, a201 + b * 201, a202 + b * 202, a203 + b * 203, a204 + b * 204, a205 + b * 205, a206 + b * 206, a207 + b * 207, a208 + b * 208, a209 + b * 209, a210 + b * 210, a211 + b * 211, a212 + b * 212, a213 + b * 213, a214 + b * 214, a215 + b * 215, a216 + b * 216, a217 + b * 217, a218 + b * 218, a219 + b * 219, a220 + b * 220, a221 + b * 221, a222 + b * 222, a223 + b * 223, a224 + b * 224, a225 + b * 225, a226 + b * 226, a227 + b * 227, a228 + b * 228, a229 + b * 229, a230 + b * 230, a231 + b * 231, a232 + b * 232, a233 + b * 233, a234 + b * 234, a235 + b * 235, a236 + b * 236, a237 + b * 237, a238 + b * 238, a239 + b * 239, a240 + b * 240, a241 + b * 241, a242 + b * 242, a243 + b * 243, a244 + b * 244, a245 + b * 245, a246 + b * 246, a247 + b * 247, a248 + b * 248, a249 + b * 249, a250 + b * 250, a251 + b * 251, a252 + b * 252, a253 + b * 253, a254 + b * 254, a255 + b * 255, a256 + b * 256, a257 + b * 257, a258 + b * 258, a259 + b * 259, a260 + b * 260, a261 + b * 261, a262 + b * 262, a263 + b * 263, a264 + b * 264, a265 + b * 265, a266 + b * 266, a267 + b * 267, a268 + b * 268, a269 + b * 269, a270 + b * 270, a271 + b * 271, a272 + b * 272, a273 + b * 273, a274 + b * 274, a275 + b * 275, a276 + b * 276, a277 + b * 277, a278 + b * 278, a279 + b * 279, a280 + b * 280, a281 + b * 281, a282 + b * 282, a283 + b * 283, a284 + b * 284, a285 + b * 285, a286 + b * 286, a287 + b * 287, a288 + b * 288, a289 + b * 289, a290 + b * 290, a291 + b * 291, a292 + b * 292, a293 + b * 293, a294 + b * 294, a295 + b * 295, a296 + b * 296, a297 + b * 297, a298 + b * 298, a299 + b * 299, a300 + b * 300, a301 + b * 301, a302 + b * 302, a303 + b * 303, a304 + b * 304, a305 + b * 305, a306 + b * 306, a307 + b * 307, a308 + b * 308, a309 + b * 309, a310 + b * 310, a311 + b * 311, a312 + b * 312, a313 + b * 313, a314 + b * 314, a315 + b * 315, a316 + b * 316, a317 + b * 317, a318 + b * 318, a319 + b * 319, a320 + b * 320, a321 + b * 321, a322 + b * 322, a323 + b * 323, a324 + b * 324, a325 + b * 325, a326 + b * 326, a327 + b * 327, a328 + b * 328, a329 + b * 329, a330 + b * 330, a331 + b * 331, a332 + b * 332, a333 + b * 333, a334 + b * 334, a335 + b * 335, a336 + b * 336, a337 + b * 337, a338 + b * 338, a339 + b * 339, a340 + b * 340, a341 + b * 341, a342 + b * 342, a343 + b * 343, a344 + b * 344, a345 + b * 345, a346 + b * 346, a347 + b * 347, a348 + b * 348, a349 + b * 349, a350 + b * 350, a351 + b * 351, a352 + b * 352, a353 + b * 353, a354 + b * 354, a355 + b * 355, a356 + b * 356, a357 + b * 357, a358 + b * 358, a359 + b * 359, a360 + b * 360, a361 + b * 361, a362 + b * 362, a363 + b * 363, a364 + b * 364, a365 + b * 365, a366 + b * 366, a367 + b * 367, a368 + b * 368, a369 + b * 369, a370 + b * 370, a371 + b * 371, a372 + b * 372, a373 + b * 373, a374 + b * 374, a375 + b * 375, a376 + b * 376, a377 + b * 377, a378 + b * 378, a379 + b * 379, a380 + b * 380, a381 + b * 381, a382 + b * 382, a383 + b * 383, a384 + b * 384, a385 + b * 385, a386 + b * 386, a387 + b * 387, a388 + b * 388, a389 + b * 389, a390 + b * 390, a391 + b * 391, a392 + b * 392, a393 + b * 393, a394 + b * 394, a395 + b * 395, a396 + b * 396, a397 + b * 397, a398 + b * 398, a399 + b * 399, a400 + b * 400, a401 + b * 401, a402 + b * 402, a403 + b * 403, a404 + b * 404, a405 + b * 405, a406 + b * 406, a407 + b * 407, a408 + b * 408, a409 + b * 409, a410 + b * 410, a411 + b * 411, a412 + b * 412, a413 + b * 413, a414 + b * 414, a415 + b * 415, a416 + b * 416, a417 + b * 417, a418 + b * 418, a419 + b * 419, a420 + b * 420, a421 + b * 421, a422 + b * 422, a423 + b * 423, a424 + b * 424, a425 + b * 425, a426 + b * 426, a427 + b * 427, a428 + b * 428, a429 + b * 429, a430 + b * 430, a431 + b * 431, a432 + b * 432, a433 + b * 433, a434 + b * 434, a435 + b * 435, a436 + b * 436, a437 + b * 437, a438 + b * 438, a439 + b * 439, a440 + b * 440, a441 + b * 441, a442 + b * 442, a443 + b * 443, a444 + b * 444, a445 + b * 445, a446 + b * 446, a447 + b * 447, a448 + b * 448, a449 + b * 449, a450 + b * 450, a451 + b * 451, a452 + b * 452, a453 + b * 453, a454 + b * 454, a455 + b * 455, a456 + b * 456, a457 + b * 457, a458 + b * 458, a459 + b * 459, a460 + b * 460, a461 + b * 461, a462 + b * 462, a463 + b * 463, a464 + b * 464, a465 + b * 465, a466 + b * 466, a467 + b * 467, a468 + b * 468, a469 + b * 469, a470 + b * 470, a471 + b * 471, a472 + b * 472, a473 + b * 473, a474 + b * 474, a475 + b * 475, a476 + b * 476, a477 + b * 477, a478 + b * 478, a479 + b * 479, a480 + b * 480, a481 + b * 481, a482 + b * 482, a483 + b * 483, a484 + b * 484, a485 + b * 485, a486 + b * 486, a487 + b * 487, a488 + b * 488, a489 + b * 489, a490 + b * 490, a491 + b * 491, a492 + b * 492, a493 + b * 493, a494 + b * 494, a495 + b * 495, a496 + b * 496, a497 + b * 497, a498 + b * 498, a499 + b * 499, a500 + b * 500, a501 + b * 501, a502 + b * 502, a503 + b * 503, a504 + b * 504, a505 + b * 505, a506 + b * 506, a507 + b * 507, a508 + b * 508, a509 + b * 509, a510 + b * 510, a511 + b * 511, a512 + b * 512, a513 + b * 513, a514 + b * 514, a515 + b * 515, a516 + b * 516, a517 + b * 517, a518 + b * 518, a519 + b * 519, a520 + b * 520, a521 + b * 521, a522 + b * 522, a523 + b * 523, a524 + b * 524, a525 + b * 525, a526 + b * 526, a527 + b * 527, a528 + b * 528, a529 + b * 529, a530 + b * 530, a531 + b * 531, a532 + b * 532, a533 + b * 533, a534 + b * 534, a535 + b * 535, a536 + b * 536, a537 + b * 537, a538 + b * 538, a539 + b * 539, a540 + b * 540, a541 + b * 541, a542 + b * 542, a543 + b * 543, a544 + b * 544, a545 + b * 545, a546 + b * 546, a547 + b * 547, a548 + b * 548, a549 + b * 549, a550 + b * 550, a551 + b * 551, a552 + b * 552, a553 + b * 553, a554 + b * 554, a555 + b * 555, a556 + b * 556, a557 + b * 557, a558 + b * 558, a559 + b * 559, a560 + b * 560, a561 + b * 561, a562 + b * 562, a563 + b * 563, a564 + b * 564, a565 + b * 565, a566 + b * 566, a567 + b * 567, a568 + b * 568, a569 + b * 569, a570 + b * 570, a571 + b * 571, a572 + b * 572, a573 + b * 573, a574 + b * 574, a575 + b * 575, a576 + b * 576, a577 + b * 577, a578 + b * 578, a579 + b * 579, a580 + b * 580, a581 + b * 581, a582 + b * 582, a583 + b * 583, a584 + b * 584, a585 + b * 585, a586 + b * 586, a587 + b * 587, a588 + b * 588, a589 + b * 589, a590 + b * 590, a591 + b * 591, a592 + b * 592, a593 + b * 593, a594 + b * 594, a595 + b * 595, a596 + b * 596, a597 + b * 597, a598 + b * 598, a599 + b * 599, a600 + b * 600, a601 + b * 601, a602 + b * 602, a603 + b * 603, a604 + b * 604, a605 + b * 605, a606 + b * 606, a607 + b * 607, a608 + b * 608, a609 + b * 609, a610 + b * 610, a611 + b * 611, a612 + b * 612, a613 + b * 613, a614 + b * 614, a615 + b * 615, a616 + b * 616, a617 + b * 617, a618 + b * 618, a619 + b * 619, a620 + b * 620, a621 + b * 621, a622 + b * 622, a623 + b * 623, a624 + b * 624, a625 + b * 625, a626 + b * 626, a627 + b * 627, a628 + b * 628, a629 + b * 629, a630 + b * 630, a631 + b * 631, a632 + b * 632, a633 + b * 633, a634 + b * 634, a635 + b * 635, a636 + b * 636, a637 + b * 637, a638 + b * 638, a639 + b * 639, a640 + b * 640, a641 + b * 641, a642 + b * 642, a643 + b * 643, a644 + b * 644, a645 + b * 645, a646 + b * 646, a647 + b * 647, a648 + b * 648, a649 + b * 649, a650 + b * 650, a651 + b * 651, a652 + b * 652, a653 + b * 653, a654 + b * 654, a655 + b * 655, a656 + b * 656, a657 + b * 657, a658 + b * 658, a659 + b * 659, a660 + b * 660, a661 + b * 661, a662 + b * 662, a663 + b * 663, a664 + b * 664, a665 + b * 665, a666 + b * 666, a667 + b * 667, a668 + b * 668, a669 + b * 669, a670 + b * 670, a671 + b * 671, a672 + b * 672, a673 + b * 673, a674 + b * 674, a675 + b * 675, a676 + b * 676, a677 + b * 677, a678 + b * 678, a679 + b * 679, a680 + b * 680, a681 + b * 681, a682 + b * 682, a683 + b * 683, a684 + b * 684, a685 + b * 685, a686 + b * 686, a687 + b * 687, a688 + b * 688, a689 + b * 689, a690 + b * 690, a691 + b * 691, a692 + b * 692, a693 + b * 693, a694 + b * 694, a695 + b * 695, a696 + b * 696, a697 + b * 697, a698 + b * 698, a699 + b * 699, a700 + b * 700, a701 + b * 701, a702 + b * 702, a703 + b * 703, a704 + b * 704, a705 + b * 705, a706 + b * 706, a707 + b * 707, a708 + b * 708, a709 + b * 709, a710 + b * 710, a711 + b * 711, a712 + b * 712, a713 + b * 713, a714 + b * 714, a715 + b * 715, a716 + b * 716, a717 + b * 717, a718 + b * 718, a719 + b * 719, a720 + b * 720, a721 + b * 721, a722 + b * 722, a723 + b * 723, a724 + b * 724, a725 + b * 725, a726 + b * 726, a727 + b * 727, a728 + b * 728, a729 + b * 729, a730 + b * 730, a731 + b * 731, a732 + b * 732, a733 + b * 733, a734 + b * 734, a735 + b * 735, a736 + b * 736, a737 + b * 737, a738 + b * 738, a739 + b * 739, a740 + b * 740, a741 + b * 741, a742 + b * 742, a743 + b * 743, a744 + b * 744, a745 + b * 745, a746 + b * 746, a747 + b * 747, a748 + b * 748, a749 + b * 749, a750 + b * 750, a751 + b * 751, a752 + b * 752, a753 + b * 753, a754 + b * 754, a755 + b * 755, a756 + b * 756, a757 + b * 757, a758 + b * 758, a759 + b * 759, a760 + b * 760, a761 + b * 761, a762 + b * 762, a763 + b * 763, a764 + b * 764, a765 + b * 765, a766 + b * 766, a767 + b * 767, a768 + b * 768, a769 + b * 769, a770 + b * 770, a771 + b * 771, a772 + b * 772, a773 + b * 773, a774 + b * 774, a775 + b * 775, a776 + b * 776, a777 + b * 777, a778 + b * 778, a779 + b * 779, a780 + b * 780, a781 + b * 781, a782 + b * 782, a783 + b * 783, a784 + b * 784, a785 + b * 785, a786 + b * 786, a787 + b * 787, a788 + b * 788, a789 + b * 789, a790 + b * 790, a791 + b * 791, a792 + b * 792, a793 + b * 793, a794 + b * 794, a795 + b * 795, a796 + b * 796, a797 + b * 797, a798 + b * 798, a799 + b * 799, a800 + b * 800, a801 + b * 801, a802 + b * 802, a803 + b * 803, a804 + b * 804, a805 + b * 805, a806 + b * 806, a807 + b * 807, a808 + b * 808, a809 + b * 809, a810 + b * 810, a811 + b * 811, a812 + b * 812, a813 + b * 813, a814 + b * 814, a815 + b * 815, a816 + b * 816, a817 + b * 817, a818 + b * 818, a819 + b * 819, a820 + b * 820, a821 + b * 821, a822 + b * 822, a823 + b * 823, a824 + b * 824, a825 + b * 825, a826 + b * 826, a827 + b * 827, a828 + b * 828, a829 + b * 829, a830 + b * 830, a831 + b * 831, a832 + b * 832, a833 + b * 833, a834 + b * 834, a835 + b * 835, a836 + b * 836, a837 + b * 837, a838 + b * 838, a839 + b * 839, a840 + b * 840, a841 + b * 841, a842 + b * 842, a843 + b * 843, a844 + b * 844, a845 + b * 845, a846 + b * 846, a847 + b * 847, a848 + b * 848, a849 + b * 849, a850 + b * 850, a851 + b * 851, a852 + b * 852, a853 + b * 853, a854 + b * 854, a855 + b * 855, a856 + b * 856, a857 + b * 857, a858 + b * 858, a859 + b * 859, a860 + b * 860, a861 + b * 861, a862 + b * 862, a863 + b * 863, a864 + b * 864, a865 + b * 865, a866 + b * 866, a867 + b * 867, a868 + b * 868, a869 + b * 869, a870 + b * 870, a871 + b * 871, a872 + b * 872, a873 + b * 873, a874 + b * 874, a875 + b * 875, a876 + b * 876, a877 + b * 877, a878 + b * 878, a879 + b * 879, a880 + b * 880, a881 + b * 881, a882 + b * 882, a883 + b * 883, a884 + b * 884, a885 + b * 885, a886 + b * 886, a887 + b * 887, a888 + b * 888, a889 + b * 889, a890 + b * 890, a891 + b * 891, a892 + b * 892, a893 + b * 893, a894 + b * 894, a895 + b * 895, a896 + b * 896, a897 + b * 897, a898 + b * 898, a899 + b * 899, a900 + b * 900, a901 + b * 901, a902 + b * 902, a903 + b * 903, a904 + b * 904, a905 + b * 905, a906 + b * 906, a907 + b * 907, a908 + b * 908, a909 + b * 909, a910 + b * 910, a911 + b * 911, a912 + b * 912, a913 + b * 913, a914 + b * 914, a915 + b * 915, a916 + b * 916, a917 + b * 917, a918 + b * 918, a919 + b * 919, a920 + b * 920, a921 + b * 921, a922 + b * 922, a923 + b * 923, a924 + b * 924, a925 + b * 925, a926 + b * 926, a927 + b * 927, a928 + b * 928, a929 + b * 929, a930 + b * 930, a931 + b * 931, a932 + b * 932, a933 + b * 933, a934 + b * 934, a935 + b * 935, a936 + b * 936, a937 + b * 937, a938 + b * 938, a939 + b * 939, a940 + b * 940, a941 + b * 941, a942 + b * 942, a943 + b * 943, a944 + b * 944, a945 + b * 945, a946 + b * 946, a947 + b * 947, a948 + b * 948, a949 + b * 949, a950 + b * 950, a951 + b * 951, a952 + b * 952, a953 + b * 953, a954 + b * 954, a955 + b * 955, a956 + b * 956, a957 + b * 957, a958 + b * 958, a959 + b * 959, a960 + b * 960, a961 + b * 961, a962 + b * 962, a963 + b * 963, a964 + b * 964, a965 + b * 965, a966 + b * 966, a967 + b * 967, a968 + b * 968, a969 + b * 969, a970 + b * 970, a971 + b * 971, a972 + b * 972, a973 + b * 973, a974 + b * 974, a975 + b * 975, a976 + b * 976, a977 + b * 977, a978 + b * 978, a979 + b * 979, a980 + b * 980, a981 + b * 981, a982 + b * 982, a983 + b * 983, a984 + b * 984, a985 + b * 985, a986 + b * 986, a987 + b * 987, a988 + b * 988, a989 + b * 989, a990 + b * 990, a991 + b * 991, a992 + b * 992, a993 + b * 993, a994 + b * 994, a995 + b * 995, a996 + b * 996, a997 + b * 997, a998 + b * 998, a999 + b * 999 from t where x = 1;
+select a from t where b in (1, 2);
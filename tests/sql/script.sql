@@ -0,0 +1,7 @@
+-- comment before statement
+select 1; select 2;;
+
+select a
+  from t
+ where b = 'x;y' and c = "d;e" -- comment; with semicolon
+   and e = 1; /* comment; with semicolon */ select 3
@@ -0,0 +1,34 @@
+select 1;
+select a, b+1 as x from t1 join t2 on t1.id = t2.id where a = 1 and b between 1 and 3 or c is not null order by a desc;
+select * from t;
+select t.* , s.a from t, s;
+select -a, - - b, +c from t;
+select a from t where a is true and b is not false or c is unknown;
+select a from t where a like 'x%' and b ilike 'y' or c <> d and e >= f;
+select a + b * c - d from t where x || y = 'z';
+select exists(select 1 from t) from dual;
+select a from t where exists (select 1) and not exists(select 2);
+select (a, b, c) from t;
+select (select 1), (1 + 2) * 3 from t;
+select f(a, b => 1, c := 2), g(), h(x) from t;
+select a from t left join s using (a, b) right outer join u on true full join v on false;
+select a from (t join s on t.a = s.a) x, (select 1) as y;
+select a from t where 'it''s' = "quo""ted";
+select 1.5, .5, 3. from t;
+select a from t where x = 1 and y = 2 and z = 3 or w = 4 or v = 5;
+select a from t where not (a and b);
+select a from t where (not a = b) = c and not (a = b) = c;
+select not a is true, not a is not true, a is not true from t where not b is false and not c is not false or not d is unknown and not e is not unknown;
+select ä, "ö" from ţ;
+select a from t where id in (1, 2, 3, 'x', null, true) and b not in (select id from u) and c in (1);
+select array[1, 2, 3], array[], array[[1,2],[3,4]], ARRAY[a, b + 1] from t;
+values (1, 'a'), (2, 'b'), (3, null) order by 1 limit 2;
+select * from (values (1, 2), (3, 4)) v;
+select ((a + b) * c), (((1))), ((1, 2), 3), ((select 1)), ((a)) is null from t;
+select a from t where ((a = 1) and (b = 2)) or ((c));
+select customer_id, customer_name, customer_address, customer_city, customer_country from customers where customer_country in ('Czech Republic', 'Slovakia', 'Austria', 'Germany', 'Poland') order by customer_name;
+select a from t group by a, b;
+select a from t order by a asc nulls first, b desc nulls last;
+select a from t natural left outer join s cross join u inner join w on true;
+select a from t limit 10 offset 5;
+select a from t where a is null or b is not null and c not in (1, 2);
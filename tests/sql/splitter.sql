@@ -0,0 +1,9 @@
+SELECT f(aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa :=-- x; y
+ 1);
+SELECT f(b :=-- x; y
+ 2);
+SELECT 1 :=>--c'
+; SELECT 2;';
+SELECT g(c := 3, d => 4) FROM t;
+SELECT 4 FROM t WHERE e:='; SELECT 5;';
+SELECT 6;
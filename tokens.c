@@ -1,4 +1,3 @@
-#include <ctype.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,84 +8,46 @@ typedef struct
 {
 	KeywordValue	value;
 	char		   *str;
+	int				len;
 	bool			reserved;
 } KeywordPair;
 
 
-static Token	tokenbuf[10];
-static int		tokenidx;
+/*
+ * Keywords table, the position of keyword in table is
+ * keyword's value - 256.
+ */
+#define PS_KEYWORD(name, value, reserved)	{ value, name, sizeof(name) - 1, reserved },
 
-static char	   *istr, *_istr, *STR;		/* STR is ptr to last read char */
-static char	   *line, *LINE;			/* can be null, when we lost information, where current line starts */
-static int		lineno, LINENO;			/* start from zero */
-static int		pos, POS;				/* can be -1, when we lost information about position from start of line */
+KeywordPair keywords[] = {
+#include "kwlist.h"
+};
 
-static bool		after_eoln;
-static bool		force8bit;
+#undef PS_KEYWORD
 
 /*
- * Keywords table, should be sorted.
+ * Compile time check of order of keywords table
  */
-KeywordPair keywords[] = {
-  { k_AND, "and", true },
-  { k_AS, "as", false },
-  { k_ASC, "asc", true },
-  { k_BETWEEN, "between", false },
-  { k_BY, "by", false },
-  { k_CROSS, "cross", false },
-  { k_CROSS_JOIN, "cross_join", true },
-  { k_DELETE, "delete", false },
-  { k_DESC, "desc", true },
-  { k_EXISTS, "exists", false },
-  { k_FALSE, "false", true },
-  { k_FIRST, "first", false },
-  { k_FROM, "from", true },
-  { k_FULL, "full", false },
-  { k_FULL_OUTER_JOIN, "full outer join", true },
-  { k_GROUP, "group", false },
-  { k_GROUP_BY, "group by", true },
-  { k_HAVING, "having", true },
-  { k_ILIKE, "ilike", false },
-  { k_IN, "in", true },
-  { k_INNER,"inner", false },
-  { k_INNER_JOIN, "inner join", true },
-  { k_INSERT, "insert", false },
-  { k_INTO, "into", true },
-  { k_IS, "is", true },
-  { k_IS_NOT, "is not", true },
-  { k_IS_NOT_NULL, "is not null", true },
-  { k_IS_NULL, "is null", true },
-  { k_JOIN, "join", false },
-  { k_LAST, "last", false },
-  { k_LEFT, "left", false },
-  { k_LEFT_OUTER_JOIN, "left outer join", true },
-  { k_LIKE, "like", false },
-  { k_LIMIT, "limit", true },
-  { k_NATURAL, "natural", false },
-  { k_NOT, "not", true },
-  { k_NOT_IN, "not in", true },
-  { k_NULL, "null", true },
-  { k_NULLS, "nulls", false },
-  { k_NULLS_FIRST, "nulls first", true },
-  { k_NULLS_LAST, "nulls last", true },
-  { k_OFFSET, "offset", true },
-  { k_ON, "on", false },
-  { k_OR, "or", true },
-  { k_ORDER, "order", false },
-  { k_ORDER_BY, "order by", true },
-  { k_OUTER, "outer", false },
-  { k_OUTER_JOIN, "outer join", true },
-  { k_RIGHT, "right", false },
-  { k_RIGHT_OUTER_JOIN, "right_outer_join", true },
-  { k_SELECT, "select", true },
-  { k_TRUE, "true", true },
-  { k_UNKNOWN, "unknown", false },
-  { k_USING, "using", false },
-  { k_VALUES, "values", false },
-  { k_WHERE, "where", true },
-  { k_WITH, "with", false }
+#define PS_KEYWORD(name, value, reserved)	kwpos_##value,
+
+enum {
+#include "kwlist.h"
+	kwpos_count
 };
 
+#undef PS_KEYWORD
+
+#define PS_KEYWORD(name, value, reserved) \
+	_Static_assert(kwpos_##value + 256 == value, "keyword \"" name "\" is not on correct position in kwlist.h");
+
+#include "kwlist.h"
+
+#undef PS_KEYWORD
+
+_Static_assert(kwpos_count == k_WITH - k_AND + 1, "kwlist.h and KeywordValue enum are not same size");
+
+#include "kwlist_d.h"
+
 /******************************************************
  *
  *  Tokenizer aux methods
@@ -94,58 +55,42 @@ KeywordPair keywords[] = {
  ******************************************************/
 
 /*
- * case insensitive searching (pstr is not zero cstring).
+ * Returns -1 if string is not known keyword (pstr is not zero cstring).
+ * Keywords are composed from ASCII letters, and only ASCII letters are
+ * lower case letters after setting 0x20 bit, so any identifier can be
+ * searched.
  */
 static int
-keyword_cmp(char *pstr, int bytes, char *keyword)
+search_keyword(char *pstr, int bytes)
 {
-	int		c;
-
-	while (bytes--)
-	{
-		c = tolower(*pstr++);
+	char	buffer[KEYWORD_MAX_LEN];
+	KeywordPair *kp;
+	int		h;
+	int		i;
 
-		if (c < *keyword)
-			return -1;
-		if (c > *keyword)
-			return 1;
+	if (bytes < KEYWORD_MIN_LEN || bytes > KEYWORD_MAX_LEN)
+		return -1;
 
-		keyword += 1;
-	}
+	h = (bytes +
+		 keyword_hash_asso[pstr[0] & 0x1f] +
+		 keyword_hash_asso[pstr[1] & 0x1f] +
+		 keyword_hash_asso[pstr[bytes - 1] & 0x1f]) & (KEYWORD_HASH_SIZE - 1);
 
-	if (*keyword)
+	if (keyword_hash_table[h] == -1)
 		return -1;
 
-	return 0;
-}
-
-/*
- * Returns -1 if string is not known keyword
- */
-static int
-search_keyword(char *pstr, int bytes)
-{
-	int		l = 0;
-	int		h = sizeof(keywords)/sizeof(KeywordPair) - 1;
+	kp = &keywords[keyword_hash_table[h]];
+	if (kp->len != bytes)
+		return -1;
 
-	while (l <= h)
-	{
-		int		m = (l + h) / 2;
+	/* ASCII only lower case */
+	for (i = 0; i < bytes; i++)
+		buffer[i] = pstr[i] | 0x20;
 
-		switch (keyword_cmp(pstr, bytes, keywords[m].str))
-		{
-			case -1:
-				h = m - 1;
-				break;
-			case 1:
-				l = l + 1;
-				break;
-			case 0:
-				return keywords[m].value;
-		}
-	}
+	if (memcmp(buffer, kp->str, bytes) != 0)
+		return -1;
 
-	return -1;
+	return kp->value;
 }
 
 /*
@@ -219,85 +164,236 @@ is_white_char(int c)
 }
 
 static bool
-is_keyword(int c)
+is_digit(int c)
 {
-	return ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'));
+	return c >= '0' && c <= '9';
 }
 
+/******************************************************
+ *
+ *  Character class scanning
+ *
+ *  Returns length of run of white chars, identifier chars
+ *  or digits. When it is possible, 32 (AVX2) or 16 (SSE2)
+ *  bytes are classified together.
+ *
+ ******************************************************/
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define SCAN_WIDTH			32
+
+typedef __m256i vec;
+
+#define vec_load(p)			_mm256_loadu_si256((const __m256i *) (p))
+#define vec_set1(c)			_mm256_set1_epi8(c)
+#define vec_eq(a, b)		_mm256_cmpeq_epi8(a, b)
+#define vec_or(a, b)		_mm256_or_si256(a, b)
+#define vec_sub(a, b)		_mm256_sub_epi8(a, b)
+#define vec_min(a, b)		_mm256_min_epu8(a, b)
+#define vec_mask(a)			((unsigned int) _mm256_movemask_epi8(a))
+
+#elif defined(__SSE2__)
+
+#include <emmintrin.h>
+
+#define SCAN_WIDTH			16
+
+typedef __m128i vec;
+
+#define vec_load(p)			_mm_loadu_si128((const __m128i *) (p))
+#define vec_set1(c)			_mm_set1_epi8(c)
+#define vec_eq(a, b)		_mm_cmpeq_epi8(a, b)
+#define vec_or(a, b)		_mm_or_si128(a, b)
+#define vec_sub(a, b)		_mm_sub_epi8(a, b)
+#define vec_min(a, b)		_mm_min_epu8(a, b)
+#define vec_mask(a)			((unsigned int) _mm_movemask_epi8(a) | 0xffff0000)
+
+#endif
+
+typedef enum
+{
+	cc_white,
+	cc_identifier,
+	cc_digit
+} CharClass;
+
+#ifdef SCAN_WIDTH
+
 /*
- * return next char from input string
+ * Returns 0xff in bytes with value from lo to hi
+ */
+static inline vec
+vec_in_range(vec x, char lo, char hi)
+{
+	vec		t = vec_sub(x, vec_set1(lo));
+
+	return vec_eq(vec_min(t, vec_set1(hi - lo)), t);
+}
+
+/*
+ * Returns bitmap of bytes of given class (bit per byte)
  */
-static char
-sgetc()
+static inline unsigned int
+vec_class_mask(vec x, CharClass cc)
 {
-	if (*_istr != '\0')
+	switch (cc)
 	{
-		if (after_eoln)
-		{
-			line = _istr;
-			pos = 0;
-			lineno += 1;
-			after_eoln = false;
-		}
+		case cc_white:
+			return vec_mask(vec_or(vec_eq(x, vec_set1(' ')),
+								   vec_in_range(x, '\t', '\r')));
+		case cc_identifier:
+			/* bytes >= 128 have highest bit, and they are identifier chars */
+			return vec_mask(vec_or(vec_or(vec_in_range(vec_or(x, vec_set1(0x20)), 'a', 'z'),
+										  vec_in_range(x, '0', '9')),
+								   vec_or(vec_eq(x, vec_set1('_')), x)));
+		case cc_digit:
+			return vec_mask(vec_in_range(x, '0', '9'));
+	}
+
+	return 0;
+}
+
+#endif
 
-		if (*_istr == '\n')
-			after_eoln = true;
+static inline bool
+is_class_char(int c, CharClass cc)
+{
+	switch (cc)
+	{
+		case cc_white:
+			return is_white_char(c);
+		case cc_identifier:
+			return is_identifier(c, false);
+		case cc_digit:
+			return is_digit(c);
+	}
+
+	return false;
+}
+
+static inline size_t
+scan_class(const char *str, const char *end, CharClass cc)
+{
+	const char *ptr = str;
+
+	/* short runs are usual, don't start vector code for them */
+	if (ptr < end && !is_class_char((unsigned char) *ptr, cc))
+		return 0;
+
+#ifdef SCAN_WIDTH
+
+	while (end - ptr >= SCAN_WIDTH)
+	{
+		unsigned int mask = ~vec_class_mask(vec_load(ptr), cc);
+
+		if (mask)
+			return ptr - str + __builtin_ctz(mask);
+
+		ptr += SCAN_WIDTH;
+	}
 
+#endif
+
+	while (ptr < end && is_class_char((unsigned char) *ptr, cc))
+		ptr++;
+
+	return ptr - str;
+}
+
+/*
+ * Returns number of new lines in string
+ */
+static int
+count_newlines(const char *str, const char *end)
+{
+	const char *ptr = str;
+	int		result = 0;
+
+#ifdef SCAN_WIDTH
+
+	vec		nl = vec_set1('\n');
+
+	while (end - ptr >= SCAN_WIDTH)
+	{
+		/* vec_mask can set bits over SCAN_WIDTH, they are zero after negation */
+		result += SCAN_WIDTH - __builtin_popcount(~vec_mask(vec_eq(vec_load(ptr), nl)));
+		ptr += SCAN_WIDTH;
+	}
+
+#endif
+
+	while (ptr < end)
+		if (*ptr++ == '\n')
+			result += 1;
+
+	return result;
+}
+
+/*
+ * return next char from input string
+ */
+static int
+sgetc(PsParser *ps)
+{
+	if (ps->_istr < ps->iend)
+	{
 		/* save position of current char */
-		STR = _istr;
-		POS = pos++;
-		LINENO = lineno;
-		LINE = line;
+		ps->STR = ps->_istr;
 
-		return *_istr++;
+		return (unsigned char) *ps->_istr++;
 	}
-	else
-		return EOF;
+
+	ps->after_eof = true;
+	return EOF;
+}
+
+/*
+ * skip n chars, the effect is same like n calls of sgetc,
+ * but the position of last char is not saved.
+ */
+static inline void
+sskip(PsParser *ps, size_t n)
+{
+	ps->_istr += n;
 }
 
 /*
  * move read ptr back
  */
 static void
-sungetc()
+sungetc(PsParser *ps)
 {
-	if (_istr > istr)
-	{
-		if (*--_istr == '\n')
-		{
-			if (!after_eoln)
-			{
-				lineno -= 1;
-				pos = -1;
-				line = NULL;
-			}
-			else
-				after_eoln = true;
-		}
-		else
-		{
-			pos -= 1;
-		}
-	}
+	/* EOF was not read from input */
+	if (ps->after_eof)
+		ps->after_eof = false;
+	else if (ps->_istr > ps->istr)
+		ps->_istr -= 1;
 }
 
 static Token *
-read_operator(Token *token, int bytes)
+read_operator(PsParser *ps, Token *token, int bytes)
 {
-	while (is_operator(sgetc()))
+	char   *str;
+
+	while (is_operator(sgetc(ps)))
 		bytes++;
 
-	sungetc();
+	sungetc(ps);
 
 	token->type = tt_operator;
 	token->bytes = bytes;
 
-	if (strncmp(token->str, "=", bytes) == 0 ||
-		strncmp(token->str, "<>", bytes) == 0 ||
-		strncmp(token->str, "<", bytes) == 0 ||
-		strncmp(token->str, ">", bytes) == 0 ||
-		strncmp(token->str, "<=", bytes) == 0 ||
-		strncmp(token->str, ">=", bytes) == 0)
+	str = TOKEN_STR(ps, token);
+
+	if (strncmp(str, "=", bytes) == 0 ||
+		strncmp(str, "<>", bytes) == 0 ||
+		strncmp(str, "<", bytes) == 0 ||
+		strncmp(str, ">", bytes) == 0 ||
+		strncmp(str, "<=", bytes) == 0 ||
+		strncmp(str, ">=", bytes) == 0)
 	{
 		token->comparing_op = true;
 	}
@@ -305,24 +401,6 @@ read_operator(Token *token, int bytes)
 	return token;
 }
 
-static int
-utf8charlen(char ch)
-{
-	if ((ch & 0x80) == 0)
-		return 1;
-
-	if ((ch & 0xF0) == 0xF0)
-		return 4;
-
-	if ((ch & 0xE0) == 0xE0)
-		return 3;
-
-	if ((ch & 0xC0) == 0xC0)
-		return 2;
-
-	return 1;
-}
-
 /******************************************************
  *
  *  Tokenizer main method
@@ -333,19 +411,15 @@ utf8charlen(char ch)
  * The source string should be immutable for all time.
  */
 static Token *
-_next_token(Token *token)
+_next_token(PsParser *ps, Token *token)
 {
 	int		c;
 
-	c = sgetc();
-	while (c != EOF && is_white_char(c))
-		c = sgetc();
+	sskip(ps, scan_class(ps->_istr, ps->iend, cc_white));
+	c = sgetc(ps);
 
 	token->type = tt_unknown;
-	token->lineno = LINENO;
-	token->line = LINE;
-	token->pos = POS;
-	token->str = STR;
+	token->offset = ps->STR - ps->istr;
 	token->quoted = false;
 	token->escaped = false;
 	token->singleline = false;
@@ -354,20 +428,32 @@ _next_token(Token *token)
 	token->natural_join = false;
 	token->comparing_op = false;
 
-	if (c >= '0' && c <= '9' || c == '.')
+	if (is_digit(c) || c == '.')
 	{
 		bool	was_dot = c == '.';
-		int		bytes = 1;
+		uint32_t bytes = 1;
 
-		c = sgetc();
-		while ((c != EOF) && ((c >= '0' && c <= '9') || (c == '.' && !was_dot)))
+		/* digits, dot can be after digit only */
+		for (;;)
 		{
-			was_dot = (c == '.');
-			bytes++;
-			c = sgetc();
-		}
+			size_t	n = scan_class(ps->_istr, ps->iend, cc_digit);
 
-		sungetc();
+			if (n > 0)
+			{
+				sskip(ps, n);
+				bytes += n;
+				was_dot = false;
+			}
+
+			if (!was_dot && ps->_istr < ps->iend && *ps->_istr == '.')
+			{
+				sskip(ps, 1);
+				bytes += 1;
+				was_dot = true;
+			}
+			else
+				break;
+		}
 
 		token->bytes = bytes;
 
@@ -381,41 +467,22 @@ _next_token(Token *token)
 	}
 	else if (is_identifier(c, true))
 	{
-		bool	is_keyword_char = is_keyword(c);
-		int		bytes = 1;
+		uint32_t bytes;
 
-		c = sgetc();
-		while ((c != EOF) && is_identifier(c, false))
-		{
-			bytes++;
-			if (is_keyword_char && !is_keyword(c))
-					is_keyword_char = false;
-
-			if (!force8bit)
-			{
-				int		i;
-
-				/* read other bytes from multibyte char */
-				for (i = 1; i < utf8charlen(c); i++)
-				{
-					if (sgetc() == EOF)
-						break;
-					bytes += 1;
-				}
-			}
-
-			c = sgetc();
-		}
-
-		sungetc();
+		/*
+		 * All bytes of multibyte chars are >= 128, so they are
+		 * identifier chars, and don't need special processing.
+		 */
+		bytes = 1 + scan_class(ps->_istr, ps->iend, cc_identifier);
+		sskip(ps, bytes - 1);
 
 		token->type = tt_ident;
 		token->bytes = bytes;
 
 		/* Maybe it is a keyword */
-		if (is_keyword_char)
+		if (bytes <= KEYWORD_MAX_LEN)
 		{
-			int		keyword_id = search_keyword(token->str, token->bytes);
+			int		keyword_id = search_keyword(ps->STR, token->bytes);
 
 			if (keyword_id != -1)
 			{
@@ -463,7 +530,7 @@ _next_token(Token *token)
 	}
 	else if (c == '=')
 	{
-		c = sgetc();
+		c = sgetc(ps);
 		if (c == '>')
 		{
 			token->type = tt_named_expr;
@@ -471,8 +538,8 @@ _next_token(Token *token)
 		}
 		else
 		{
-			sungetc();
-			token = read_operator(token, 1);
+			sungetc(ps);
+			token = read_operator(ps, token, 1);
 		}
 	}
 	else if (c == '\'')
@@ -480,13 +547,13 @@ _next_token(Token *token)
 		int		bytes = 1;
 		bool	closed = false;
 
-		c = sgetc();
+		c = sgetc(ps);
 		while (c != EOF)
 		{
 			if (c == '\'')
 			{
 				/* look ahead */
-				c = sgetc();
+				c = sgetc(ps);
 				if (c == '\'')
 				{
 					/* double single quotes */
@@ -494,7 +561,7 @@ _next_token(Token *token)
 				}
 				else
 				{
-					sungetc();
+					sungetc(ps);
 					closed = true;
 					bytes++;
 					break;
@@ -502,12 +569,16 @@ _next_token(Token *token)
 			}
 
 			bytes++;
-			c = sgetc();
+			c = sgetc(ps);
 		}
 
 		if (!closed)
 		{
-			fprintf(stderr, "unclosed string on line %d position %d\n", token->lineno + 1, token->pos);
+			int		lineno;
+			uint32_t pos;
+
+			get_token_position(ps, token, &lineno, &pos);
+			parser_error(ps, PS_ERROR_LEXER, "unclosed string on line %d position %u", lineno, pos);
 			return NULL;
 		}
 
@@ -522,13 +593,13 @@ _next_token(Token *token)
 		/*
 		 * SQL string can be multiline, so local buffer should be used
 		 */
-		c = sgetc();
+		c = sgetc(ps);
 		while (c != EOF)
 		{
 			if (c == '"')
 			{
 				/* look ahead */
-				c = sgetc();
+				c = sgetc(ps);
 				if (c == '"')
 				{
 					/* double double quotes */
@@ -536,7 +607,7 @@ _next_token(Token *token)
 				}
 				else
 				{
-					sungetc();
+					sungetc(ps);
 					closed = true;
 					bytes++;
 					break;
@@ -544,12 +615,16 @@ _next_token(Token *token)
 			}
 
 			bytes++;
-			c = sgetc();
+			c = sgetc(ps);
 		}
 
 		if (!closed)
 		{
-			fprintf(stderr, "unclosed identifier on line %d position %d\n", token->lineno + 1, token->pos);
+			int		lineno;
+			uint32_t pos;
+
+			get_token_position(ps, token, &lineno, &pos);
+			parser_error(ps, PS_ERROR_LEXER, "unclosed identifier on line %d position %u", lineno, pos);
 			return NULL;
 		}
 
@@ -560,18 +635,18 @@ _next_token(Token *token)
 	else if (c == '/')
 	{
 
-		c = sgetc();
+		c = sgetc(ps);
 		if (c == '*') /* multiline comment */
 		{
 			int		bytes = 2;
 			bool	closed = false;
 
-			c = sgetc();
+			c = sgetc(ps);
 			while (c != EOF)
 			{
 				if (c == '*')
 				{
-					c = sgetc();
+					c = sgetc(ps);
 					if (c == '/')
 					{
 						bytes += 2;
@@ -579,16 +654,20 @@ _next_token(Token *token)
 						break;
 					}
 					else
-						sungetc();
+						sungetc(ps);
 				}
 
 				bytes++;
-				c = sgetc();
+				c = sgetc(ps);
 			}
 
 			if (!closed)
 			{
-				fprintf(stderr, "unclosed comments on line %d position %d\n", token->lineno + 1, token->pos);
+				int		lineno;
+				uint32_t pos;
+
+				get_token_position(ps, token, &lineno, &pos);
+				parser_error(ps, PS_ERROR_LEXER, "unclosed comments on line %d position %u", lineno, pos);
 				return NULL;
 			}
 
@@ -597,26 +676,26 @@ _next_token(Token *token)
 		}
 		else
 		{
-			sungetc();
-			token = read_operator(token, 1);
+			sungetc(ps);
+			token = read_operator(ps, token, 1);
 		}
 	}
 	else if (c == '-')
 	{
-		c = sgetc();
+		c = sgetc(ps);
 		if (c == '-')
 		{
 			int bytes = 2;
 
 			/* read to endof line */
-			c = sgetc();
+			c = sgetc(ps);
 			while (c != EOF && c != '\n')
 			{
 				bytes++;
-				c = sgetc();
+				c = sgetc(ps);
 			}
 
-			sungetc();
+			sungetc(ps);
 
 			token->type = tt_comment;
 			token->bytes = bytes;
@@ -624,17 +703,17 @@ _next_token(Token *token)
 		}
 		else
 		{
-			sungetc();
-			token = read_operator(token, 1);
+			sungetc(ps);
+			token = read_operator(ps, token, 1);
 		}
 	}
 	else if (is_operator(c))
 	{
-		token = read_operator(token, 1);
+		token = read_operator(ps, token, 1);
 	}
 	else if (c == ':')
 	{
-		c = sgetc();
+		c = sgetc(ps);
 		if (c == ':')
 		{
 			token->type = tt_cast_operator;
@@ -647,7 +726,7 @@ _next_token(Token *token)
 		}
 		else
 		{
-			sungetc();
+			sungetc(ps);
 			token->type = tt_other;
 			token->bytes = 1;
 			token->value = ':';
@@ -675,265 +754,522 @@ _next_token(Token *token)
  ******************************************************/
 
 /*
- * ensure correct keyword table sorting
+ * Initialize module variables and parsed string. The string
+ * doesn't need to be terminated by zero, the lexer never reads
+ * after str + len (so read only mapped file can be used directly).
+ */
+void
+init_lexer(PsParser *ps, char *str, size_t len, bool _force8bit)
+{
+	/* tokens holds 32bit offsets */
+	if (len > UINT32_MAX)
+	{
+		parser_fatal(ps, PS_ERROR_INPUT_TOO_LONG, "input is too long");
+	}
+
+	ps->_istr = ps->istr = str;
+	ps->iend = str + len;
+	ps->tokenidx = 0;
+	ps->nlookahead = 0;
+	ps->after_eof = false;
+	ps->nlines = -1;
+	ps->line_offset = 0;
+	ps->pos_offset = 0;
+	ps->tokens_ready = false;
+	ps->force8bit = _force8bit;
+}
+
+/*
+ * Builds index of starts of lines. It is called only when position
+ * of some token in line is required.
  */
 static void
-check_keyword_table()
+build_line_index(PsParser *ps)
 {
-	int		values = sizeof(keywords)/sizeof(KeywordPair);
+	int		nlines = count_newlines(ps->istr, ps->iend) + 1;
+	char   *ptr = ps->istr;
 	int		i;
 
-	for (i = 0; i < values; i++)
+	if (nlines > ps->line_starts_size)
 	{
-		KeywordPair *kp = &keywords[i];
+		free(ps->line_starts);
+		ps->line_starts_size = 0;
 
-		if (kp->value != i + 256)
-		{
-			fprintf(stderr, "unexpected keyword value (%d expected %d) for keyword \"%s\"\n", kp->value, i + 256, kp->str);
-			exit(1);
-		}
+		ps->line_starts = malloc(nlines * sizeof(uint32_t));
+		if (!ps->line_starts)
+			out_of_memory();
 
-		if (i > 1)
-		{
-			if (keyword_cmp(keywords[i].str, strlen(keywords[i].str), keywords[i-1].str) != 1)
-			{
-				fprintf(stderr, "unsorted keyword table (%s %s)\n", keywords[i].str, keywords[i-1].str);
-				exit(1);
-			}
-		}
+		ps->line_starts_size = nlines;
 	}
+
+	ps->line_starts[0] = 0;
+
+	for (i = 1; i < nlines; i++)
+	{
+		ptr = (char *) memchr(ptr, '\n', ps->iend - ptr) + 1;
+		ps->line_starts[i] = (uint32_t) (ptr - ps->istr);
+	}
+
+	ps->nlines = nlines;
 }
 
 /*
- * Initialize module variables and parsed string
+ * Returns line number (from 1) and position in line (from 0)
+ * of token.
  */
 void
-init_lexer(char *str, bool _force8bit)
+get_token_position(PsParser *ps, Token *token, int *lineno, uint32_t *pos)
 {
-	_istr = istr = str;
-	line = str;
-	lineno = 0;
-	pos = 0;
-	tokenidx = 0;
-	after_eoln = false;
-	force8bit = _force8bit;
+	uint32_t offset = token->offset;
+	int		l = 0;
+	int		h;
 
-	/* check prereq. */
-	check_keyword_table();
+	if (ps->nlines == -1)
+		build_line_index(ps);
+
+	/* search last line that starts before offset */
+	h = ps->nlines - 1;
+	while (l < h)
+	{
+		int		m = (l + h + 1) / 2;
+
+		if (ps->line_starts[m] <= offset)
+			l = m;
+		else
+			h = m - 1;
+	}
+
+	*lineno = l + 1 + ps->line_offset;
+	*pos = offset - ps->line_starts[l];
+
+	/* input starts inside the line */
+	if (l == 0)
+		*pos += ps->pos_offset;
 }
 
+/*
+ * When tokens are in token array, then only cursor is moved back,
+ * and the token should be last read token.
+ */
 void
-push_token(Token *token)
+push_token(PsParser *ps, Token *token)
 {
-	/* tokenbuf[0] is reserved */
-	if (tokenidx < 10)
-		memcpy(&tokenbuf[tokenidx++], token, sizeof(Token));
-	else
+	if (ps->stats)
+		ps->stats->push_token_calls += 1;
+
+	if (ps->tokens_ready)
 	{
-		fprintf(stderr, "no space in token buffer");
-		exit(1);
+		ps->tokencur -= 1;
+		return;
 	}
+
+	/* tokenbuf[0] is reserved */
+	if (ps->tokenidx < 10)
+		memcpy(&ps->tokenbuf[ps->tokenidx++], token, sizeof(Token));
+	else
+		parser_fatal(ps, PS_ERROR_INTERNAL, "no space in token buffer");
 }
 
-static Token *
-possible_multiverb2(Token *token,
-					KeywordValue required,
-					KeywordValue newval,
-					bool *changed)
+/*
+ * Deadline is checked only every PS_DEADLINE_CHECK_TOKENS tokens,
+ * because reading of time is not cheap.
+ */
+static void
+check_deadline(PsParser *ps)
 {
-	Token	t, *_t;
+	if (ps->deadline > 0.0 && stats_time() > ps->deadline)
+		budget_exceeded(ps, PS_ERROR_TIMEOUT,
+						"statement timed out (timeout is %d ms)",
+						ps->budget.timeout);
+}
 
-	_t = next_token(&t);
-	if (!_t)
-		return token;
+static void
+check_token_budget(PsParser *ps)
+{
+	ps->statement_tokens += 1;
+
+	if (ps->budget.max_tokens > 0 &&
+		ps->statement_tokens > ps->budget.max_tokens)
+		budget_exceeded(ps, PS_ERROR_TOO_MANY_TOKENS,
+						"statement has too many tokens (max tokens is %lld)",
+						(long long) ps->budget.max_tokens);
+
+	if (ps->statement_tokens % PS_DEADLINE_CHECK_TOKENS == 0)
+		check_deadline(ps);
+}
 
-	if (t.type == tt_keyword && t.value == required)
+/*
+ * Returns n-th not consumed token of lexer (without processing of
+ * multiverbs). The tokens are lexed to small lookahead buffer, that
+ * is enough for longest multiverb (NATURAL LEFT OUTER JOIN). Returns
+ * NULL, when there is lexer error.
+ *
+ * The budget is checked, when the token is in lookahead already, so
+ * after exceeded budget the token can be read by skip_statement.
+ */
+static Token *
+peek_token(PsParser *ps, int n)
+{
+	while (ps->nlookahead <= n)
 	{
-		token->value = newval;
-		token->reserved = keywords[token->value - 256].reserved;
-		token->str = keywords[token->value - 256].str;
-		token->bytes = strlen(token->str);
+		if (!_next_token(ps, &ps->lookahead[ps->nlookahead]))
+			return NULL;
 
-		if (changed)
-			*changed = true;
+		ps->nlookahead += 1;
 
-		return token;
+		if (ps->budget_jmp)
+			check_token_budget(ps);
 	}
 
-	push_token(_t);
+	return &ps->lookahead[n];
+}
 
-	if (changed)
-		*changed = false;
+static void
+consume_tokens(PsParser *ps, int n)
+{
+	if (n == 0)
+		return;
 
-	return token;
+	ps->nlookahead -= n;
+
+	if (ps->nlookahead > 0)
+		memmove(&ps->lookahead[0], &ps->lookahead[n],
+				ps->nlookahead * sizeof(Token));
 }
 
+static bool
+is_lookahead_keyword(Token *token, KeywordValue k)
+{
+	return token && token->type == tt_keyword && token->value == (int) k;
+}
 
-static Token *
-possible_multiverb3(Token *token,
-					KeywordValue required,
-					KeywordValue required2,
-					KeywordValue newval,
-					bool *changed)
+/*
+ * When tokens n and n + 1 of lookahead are keywords second and third
+ * (when it is not zero), then token is changed to multiverb newval.
+ * Returns number of used tokens of lookahead.
+ */
+static int
+possible_multiverb(PsParser *ps, Token *token, int n,
+				   KeywordValue second,
+				   KeywordValue third,
+				   KeywordValue newval)
 {
-	Token	t, *_t;
+	Token	   *last;
 
-	_t = next_token(&t);
-	if (!_t)
-		return token;
+	last = peek_token(ps, n);
+	if (!is_lookahead_keyword(last, second))
+		return 0;
 
-	if (t.type == tt_keyword && t.value == required)
+	if (third)
 	{
-		Token	t2, *_t2;
+		last = peek_token(ps, n + 1);
+		if (!is_lookahead_keyword(last, third))
+			return 0;
+	}
 
-		_t2 = next_token(&t2);
-		if (_t2)
-		{
-			if (t2.type == tt_keyword && t2.value == required2)
+	token->value = newval;
+	token->reserved = keywords[token->value - 256].reserved;
+	token->bytes = last->offset + last->bytes - token->offset;
+
+	return third ? 2 : 1;
+}
+
+/*
+ * Possible multiverbs like GROUP BY, ORDER BY. The token is changed
+ * to multiverb, when the tokens of lookahead from n-th token are rest
+ * of multiverb. Returns number of used tokens of lookahead. Only the
+ * following tokens are lexed, so there is not any recursion for long
+ * runs of keywords.
+ */
+static int
+fuse_multiverb(PsParser *ps, Token *token, int n)
+{
+	int		used;
+
+	if (token->type != tt_keyword)
+		return 0;
+
+	switch (token->value)
+	{
+		case k_GROUP:
+			return possible_multiverb(ps, token, n, k_BY, 0, k_GROUP_BY);
+
+		case k_ORDER:
+			return possible_multiverb(ps, token, n, k_BY, 0, k_ORDER_BY);
+
+		case k_NOT:
+			return possible_multiverb(ps, token, n, k_IN, 0, k_NOT_IN);
+
+		case k_NULLS:
+			used = possible_multiverb(ps, token, n, k_FIRST, 0, k_NULLS_FIRST);
+			if (used == 0)
+				used = possible_multiverb(ps, token, n, k_LAST, 0, k_NULLS_LAST);
+			return used;
+
+		case k_IS:
+			used = possible_multiverb(ps, token, n, k_NOT, k_NULL, k_IS_NOT_NULL);
+			if (used == 0)
+				used = possible_multiverb(ps, token, n, k_NULL, 0, k_IS_NULL);
+			return used;
+
+		case k_INNER:
+			return possible_multiverb(ps, token, n, k_JOIN, 0, k_INNER_JOIN);
+
+		case k_CROSS:
+			return possible_multiverb(ps, token, n, k_JOIN, 0, k_CROSS_JOIN);
+
+		case k_OUTER:
+			/* optional OUTER JOIN */
+			return possible_multiverb(ps, token, n, k_JOIN, 0, k_OUTER_JOIN);
+
+		case k_LEFT:
+			used = possible_multiverb(ps, token, n, k_JOIN, 0, k_LEFT_OUTER_JOIN);
+			if (used == 0)
+				used = possible_multiverb(ps, token, n, k_OUTER, k_JOIN, k_LEFT_OUTER_JOIN);
+			return used;
+
+		case k_RIGHT:
+			used = possible_multiverb(ps, token, n, k_JOIN, 0, k_RIGHT_OUTER_JOIN);
+			if (used == 0)
+				used = possible_multiverb(ps, token, n, k_OUTER, k_JOIN, k_RIGHT_OUTER_JOIN);
+			return used;
+
+		case k_FULL:
+			used = possible_multiverb(ps, token, n, k_JOIN, 0, k_FULL_OUTER_JOIN);
+			if (used == 0)
+				used = possible_multiverb(ps, token, n, k_OUTER, k_JOIN, k_FULL_OUTER_JOIN);
+			return used;
+
+		case k_NATURAL:
 			{
-				token->value = newval;
-				token->reserved = keywords[token->value - 256].reserved;
-				token->str = keywords[token->value - 256].str;
-				token->bytes = strlen(token->str);
+				Token	   *next;
+				Token		join;
+
+				/* NATURAL can be only before other multiverbs */
+				next = peek_token(ps, n);
+				if (n > 0 || !next || is_lookahead_keyword(next, k_NATURAL))
+					return 0;
+
+				memcpy(&join, next, sizeof(Token));
+				used = fuse_multiverb(ps, &join, n + 1);
 
-				if (changed)
-					*changed = true;
+				if (join.type == tt_keyword && join.reserved)
+				{
+					switch (join.value)
+					{
+						case k_JOIN:
+						case k_CROSS_JOIN:
+						case k_FULL_OUTER_JOIN:
+						case k_LEFT_OUTER_JOIN:
+						case k_RIGHT_OUTER_JOIN:
+							token->value = join.value;
+							token->reserved = keywords[token->value - 256].reserved;
+							token->bytes = join.offset + join.bytes - token->offset;
+							token->natural_join = true;
+
+							return used + 1;
+
+						default:
+							;
+					}
+				}
 
-				return token;
+				return 0;
 			}
 
-			push_token(_t2);
-		}
+		default:
+			return 0;
 	}
+}
 
-	push_token(_t);
+Token *
+next_token(PsParser *ps, Token *token)
+{
+	Token	   *first;
+
+	if (ps->stats)
+		ps->stats->next_token_calls += 1;
+
+	if (ps->tokens_ready)
+	{
+		/* after end of array returns EOF token repeatedly */
+		int		idx = ps->tokencur < ps->ntokens ? ps->tokencur : ps->ntokens - 1;
+
+		ps->tokencur += 1;
+
+		/* the parser can be slow, although the tokens are read already */
+		if (ps->budget_jmp && ps->tokencur % PS_DEADLINE_CHECK_TOKENS == 0)
+			check_deadline(ps);
+
+		return &ps->tokens[idx];
+	}
+
+	/* tokens pushed back by parser, when token array is not used */
+	if (ps->tokenidx > 0)
+	{
+		memcpy(token, &ps->tokenbuf[--ps->tokenidx], sizeof(Token));
+		return token;
+	}
+
+	/*
+	 * Usually the token is lexed directly to result. When budgets are
+	 * checked, then it should be in lookahead, so it is not lost after
+	 * exceeded budget.
+	 */
+	if (ps->nlookahead == 0 && !ps->budget_jmp)
+	{
+		if (!_next_token(ps, token))
+			return NULL;
+	}
+	else
+	{
+		first = peek_token(ps, 0);
+		if (!first)
+			return NULL;
+
+		memcpy(token, first, sizeof(Token));
+		consume_tokens(ps, 1);
+	}
 
-	if (changed)
-		*changed = false;
+	if (token->type == tt_keyword)
+		consume_tokens(ps, fuse_multiverb(ps, token, 0));
 
 	return token;
 }
 
-Token *
-next_token(Token *token)
+static void
+reserve_token(PsParser *ps)
 {
-	bool	changed;
+	if (ps->ntokens == ps->tokens_size)
+	{
+		int		size = ps->tokens_size > 0 ? ps->tokens_size * 2 : 1024;
+		Token  *tokens;
 
-	if (tokenidx > 0)
-		memcpy(token, &tokenbuf[--tokenidx], sizeof(Token));
-	else
+		/* the array should be valid, when out_of_memory doesn't exit */
+		tokens = realloc(ps->tokens, size * sizeof(Token));
+		if (!tokens)
+			out_of_memory();
+
+		ps->tokens = tokens;
+		ps->tokens_size = size;
+	}
+}
+
+/*
+ * Reads tokens to token array until EOF (or semicolon, when
+ * statement is true).
+ */
+static bool
+tokenize_tokens(PsParser *ps, bool statement)
+{
+	Token  *token;
+
+	ps->tokens_ready = false;
+	ps->ntokens = 0;
+	ps->tokencur = 0;
+	ps->tokens_start = ps->_istr - ps->istr;
+
+	for (;;)
 	{
-		token = _next_token(token);
+		reserve_token(ps);
 
-		/* possible multiverbs like GROUP BY, ORDER BY */
-		if (token->type == tt_keyword)
-		{
-			if (token->value == k_GROUP)
-				/* GROUP BY */
-				token = possible_multiverb2(token, k_BY, k_GROUP_BY, NULL);
-			else if (token->value == k_ORDER)
-				/* ORDER BY */
-				token = possible_multiverb2(token, k_BY, k_ORDER_BY, NULL);
-			else if (token->value == k_NOT)
-				/* NOT IN */
-				token = possible_multiverb2(token, k_IN, k_NOT_IN, NULL);
-			else if (token->value == k_NULLS)
-			{
-				token = possible_multiverb2(token, k_FIRST, k_NULLS_FIRST, &changed);
-				if (!changed)
-					token = possible_multiverb2(token, k_LAST, k_NULLS_LAST, NULL);
-			}
-			else if (token->value == k_IS)
-			{
-				bool	changed;
+		token = next_token(ps, &ps->tokens[ps->ntokens]);
+		if (!token)
+			return false;
 
-				/* IS NOT NULL */
-				token = possible_multiverb3(token, k_NOT, k_NULL, k_IS_NOT_NULL, &changed);
-				if (!changed)
-					/* IS NULL */
-					token = possible_multiverb2(token, k_NULL, k_IS_NULL, NULL);
-			}
-			else if (token->value == k_INNER)
-				/* INNER JOIN */
-				token = possible_multiverb2(token, k_JOIN, k_INNER_JOIN, NULL);
-			else if (token->value == k_CROSS)
-				/* CROSS JOIN */
-				token = possible_multiverb2(token, k_JOIN, k_CROSS_JOIN, NULL);
-			else if (token->value == k_OUTER)
-				/* optional OUTER JOIN */
-				token = possible_multiverb2(token, k_JOIN, k_OUTER_JOIN, NULL);
-			else if (token->value == k_LEFT)
-			{
-				/* LEFT JOIN */
-				token = possible_multiverb2(token, k_JOIN, k_LEFT_OUTER_JOIN, &changed);
-				if (!changed)
-					/* LEFT OUTER JOIN */
-					token = possible_multiverb2(token, k_OUTER_JOIN, k_LEFT_OUTER_JOIN, NULL);
-			}
-			else if (token->value == k_RIGHT)
-			{
-				/* RIGHT JOIN */
-				token = possible_multiverb2(token, k_JOIN, k_RIGHT_OUTER_JOIN, &changed);
-				if (!changed)
-					/* RIGHT OUTER JOIN */
-					token = possible_multiverb2(token, k_OUTER_JOIN, k_RIGHT_OUTER_JOIN, NULL);
-			}
-			else if (token->value == k_FULL)
-			{
-				/* FULL JOIN */
-				token = possible_multiverb2(token, k_JOIN, k_FULL_OUTER_JOIN, &changed);
-				if (!changed)
-					/* FULL OUTER JOIN */
-					token = possible_multiverb2(token, k_OUTER_JOIN, k_FULL_OUTER_JOIN, NULL);
-			}
-			else if (token->value == k_NATURAL)
-			{
-				Token	t2, *_t2;
+		ps->ntokens += 1;
 
-				_t2 = next_token(&t2);
-				if (_t2)
-				{
-					bool	processed = false;
+		if (ps->stats)
+			ps->stats->tokens[token->type + 1] += 1;
 
-					if (t2.type == tt_keyword && t2.reserved)
-					{
-						switch (t2.value)
-						{
-							case k_JOIN:
-							case k_CROSS_JOIN:
-							case k_FULL_OUTER_JOIN:
-							case k_LEFT_OUTER_JOIN:
-							case k_RIGHT_OUTER_JOIN:
-								{
-									token->value = t2.value;
-									token->reserved = keywords[token->value - 256].reserved;
-									token->str = keywords[token->value - 256].str;
-									token->bytes = strlen(token->str);
-									token->natural_join = true;
-
-									processed = true;
-									break;
-								}
-							default:
-								;
-						}
-					}
+		if (token->type == tt_EOF)
+			break;
 
-					if (!processed)
-						push_token(_t2);
-				}
-			}
+		if (statement && token->type == tt_semicolon)
+		{
+			Token  *eof;
+
+			/* statement is closed by EOF token like whole input */
+			reserve_token(ps);
+
+			eof = &ps->tokens[ps->ntokens++];
+			memset(eof, 0, sizeof(Token));
+			eof->type = tt_EOF;
+			eof->value = -1;
+			eof->offset = ps->tokens[ps->ntokens - 2].offset + 1;
+			break;
 		}
 	}
 
-	return token;
+	ps->tokens_ready = true;
+
+	return true;
+}
+
+/*
+ * Skips the rest of statement, when its tokenization was canceled by
+ * exceeded budget. The tokens are not stored, only the last token is
+ * in token array, so the text of statement can be displayed.
+ */
+void
+skip_statement(PsParser *ps)
+{
+	Token	t, last, *token;
+
+	ps->tokens_ready = false;
+	last.type = tt_EOF;
+
+	for (;;)
+	{
+		token = next_token(ps, &t);
+
+		/* lexer error, the rest of input is the statement */
+		if (!token)
+			return;
+
+		if (token->type == tt_EOF)
+			break;
+
+		memcpy(&last, token, sizeof(Token));
+
+		if (token->type == tt_semicolon)
+			break;
+	}
+
+	ps->ntokens = 0;
+	ps->tokencur = 0;
+	reserve_token(ps);
+	memcpy(&ps->tokens[ps->ntokens++], last.type != tt_EOF ? &last : token, sizeof(Token));
+
+	ps->tokens_ready = true;
+}
+
+/*
+ * Reads all tokens of input to token array. After this, next_token
+ * and push_token only move cursor in this array, so lookahead is
+ * not limited and it is cheap.
+ */
+bool
+tokenize(PsParser *ps)
+{
+	return tokenize_tokens(ps, false);
 }
 
+/*
+ * Reads tokens of next statement (up to semicolon) to token array.
+ * The lexer continues from the end of previous statement, so whole
+ * script is lexed only once.
+ */
+bool
+tokenize_statement(PsParser *ps)
+{
+	return tokenize_tokens(ps, true);
+}
 
-static char *
-token_type_name(Token *token)
+const char *
+token_type_name(TokenType type)
 {
-	switch (token->type)
+	switch (type)
 	{
 		case tt_EOF:
 			return "EOF";
@@ -963,24 +1299,30 @@ token_type_name(Token *token)
 			return "Operator";
 		case tt_cast_operator:
 			return "Cast operator";
+		case tt_dot:
+			return "Dot";
 		case tt_comma:
 			return "Comma";
+		case tt_named_expr:
+			return "Named expr";
+		case tt_semicolon:
+			return "Semicolon";
 		default:
 			return "Unknown";
 	}
 }
 
 static void
-debug_print_token_indent(Token *token, int indent)
+debug_print_token_indent(PsParser *ps, Token *token, int indent)
 {
 
 	if (token)
 	{
 		fprintf(stderr, "DEBUG: %*s", indent, "");
 		fprintf(stderr, "token: %8s, content:\"%.*s\"",
-							token_type_name(token),
+							token_type_name(token->type),
 							token->bytes,
-							token->str);
+							TOKEN_STR(ps, token));
 
 		if (token->value != -1)
 			fprintf(stderr, ", value: %d", token->value);
@@ -995,15 +1337,15 @@ debug_print_token_indent(Token *token, int indent)
 }
 
 void
-debug_print_token(Token *token)
+debug_print_token(PsParser *ps, Token *token)
 {
-	debug_print_token_indent(token, 0);
+	debug_print_token_indent(ps, token, 0);
 }
 
 void
-push_token_debug(Token *token, char *str)
+push_token_debug(PsParser *ps, Token *token, char *str)
 {
 	fprintf(stderr, "DEBUG: PUSH_TOKEN \"%s\"\n", str);
-	debug_print_token_indent(token, 4);
-	push_token(token);
+	debug_print_token_indent(ps, token, 4);
+	push_token(ps, token);
 }
\ No newline at end of file